@@ -1,5 +1,7 @@
 #include "idep_alias_dep.h"
 
+#include <string.h>
+
 #include <iostream>
 
 // This file contains a main program to exercise the idep_aliasdep component.
@@ -11,8 +13,10 @@ return
 "  The following 3 command line interface modes are supported:\n"
 "\n"
 "    adep [-s] [-a<alias>] [-f<filelist> ] [-X<fn>] [-x<xFile>] <filename>*\n"
-"    adep -v [-a<alias>] [-f<filelist>] [-X<fn>] [-x<xFile>] <cfilename>*\n"
-"    adep -e [-a<alias>] [-f<filelist>] [-X<fn>] [-x<xFile>] <cfilename>*\n"
+"    adep -v [-a<alias>] [-f<filelist>] [-X<fn>] [-x<xFile>]\n"
+"            [--cache[=<file>] | --no-cache] <cfilename>*\n"
+"    adep -e [-a<alias>] [-f<filelist>] [-X<fn>] [-x<xFile>]\n"
+"            [--cache[=<file>] | --no-cache] <cfilename>*\n"
 "\n"
 "      -s           Suppress the printing of suffixes for unpaired names.\n"
 "      -v           Verify file contains component name as 1st dependency.\n"
@@ -21,6 +25,10 @@ return
 "      -f<filelist> Specify file containing a list of files to consider.\n"
 "      -X<fn>       Specify name of file to ignore during processing.\n"
 "      -x<xFile>    Specify file containing a list of filenames to ignore.\n"
+"      --cache[=<file>] Keep the includes found in each file in <file>\n"
+"                   (default .idep-cache), so that unchanged files are not\n"
+"                   scanned again.  No cache is used unless this is given.\n"
+"      --no-cache   Use no cache file, even if --cache is given.\n"
 "\n"
 "    Each filename on the command line specifies a file to be considered for\n"
 "    processing.  Specifying no arguments indicates that the list of files\n"
@@ -37,6 +45,8 @@ return
 
 static enum { IOERROR = -1, GOOD = 0, BAD = 1 } s_status = GOOD;
 
+static const char s_defaultCacheFile[] = ".idep-cache";
+
 static std::ostream& PrintError() {
   s_status = IOERROR;
   return std::cerr << "error: ";
@@ -77,6 +87,8 @@ int main(int argc, char* argv[]) {
     int suffixFlag = 1;      // -s sets this to 0
     int verifyFlag = 0;      // -v sets this to 1
     int extractFlag = 0;     // -e sets this to 1
+    const char *cacheFile = 0;  // --cache[=<file>] sets this
+    int noCacheFlag = 0;     // --no-cache sets this to 1
 
     idep::AliasDep environment;
     for (int i = 1; i < argc; ++i) {
@@ -144,6 +156,23 @@ int main(int argc, char* argv[]) {
                 }
                 extractFlag = 1;
               } break;
+              case '-': {
+                if (0 == strcmp(word, "--cache")) {
+                    cacheFile = s_defaultCacheFile;
+                    break;
+                }
+                if (0 == strncmp(word, "--cache=", 8) && word[8]) {
+                    cacheFile = word + 8;
+                    break;
+                }
+                if (0 == strcmp(word, "--no-cache")) {
+                    noCacheFlag = 1;
+                    break;
+                }
+                PrintError() << "unknown option \"" << word << "\"." << std::endl
+                             << help();
+                return s_status;
+              } break;
               default: {
                  PrintError() << "unknown option \"" << word << "\"." << std::endl
                               << help();
@@ -161,6 +190,8 @@ int main(int argc, char* argv[]) {
         environment.inputFileNames();
     }
 
+    environment.setCacheFile(noCacheFlag ? 0 : cacheFile);
+
     int result = extractFlag ? environment.extract(std::cout, std::cerr)
                              : verifyFlag
                              ? environment.verify(std::cerr)
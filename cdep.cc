@@ -1,7 +1,12 @@
 #include "idep_compile_dep.h"
+#include "idep_condensation.h"
+#include "idep_file_loader.h"
+#include "idep_row_kernel.h"
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <iostream>
 
@@ -12,12 +17,27 @@ const char cdep_usage[] =
 "\n"
 "  The following command line interface is supported:\n"
 "\n"
-"    cdep [-I<dir>] [-i<dirlist>] [-f<filelist>] [-x] <filename>*\n"
+"    cdep [-I<dir>] [-i<dirlist>] [-f<filelist>] [-x] [-K<kernel>]\n"
+"         [-j<threads>] [-c] [-D<macro>[=<value>]] [-U<macro>] [-a<engine>]\n"
+"         [--cache[=<file>] | --no-cache] <filename>*\n"
 "\n"
 "      -I<dir>      Specify include directory to search.\n"
 "      -i<dirlist>  Specify file containing a list of directories to search.\n"
 "      -f<filelist> Specify file containing a list of files to process.\n"
 "      -x           Do _not_ check recursively for nested includes.\n"
+"      -K<kernel>   Force the closure kernel: scalar, sse2, avx2 or avx512.\n"
+"      -j<threads>  Use this many threads for closures (0: one per processor).\n"
+"      -c           Skip includes that are commented out or in inactive\n"
+"                   #if/#ifdef sections; unknown conditions count as true.\n"
+"      -D<macro>    Define a macro for deciding which sections are inactive\n"
+"                   (as NAME or NAME=VALUE); implies -c.\n"
+"      -U<macro>    Undefine a macro for the same purpose; implies -c.\n"
+"      -a<engine>   Load all files up front, many at a time, with the engine:\n"
+"                   auto, io_uring or threads.  The output is the same.\n"
+"      --cache[=<file>] Keep the includes found in each file in <file>\n"
+"                   (default .idep-cache), so that unchanged files are not\n"
+"                   scanned again.  No cache is used unless this is given.\n"
+"      --no-cache   Use no cache file, even if --cache is given.\n"
 "\n"
 "    Each filename on the command line specifies a file to be considered for\n"
 "    processing.  Specifying no arguments indicates that the list of files\n"
@@ -29,6 +49,8 @@ const char cdep_usage[] =
 
 const size_t kBufferSize = 2048;
 
+const char kDefaultCacheFile[] = ".idep-cache";
+
 void Printf(const char* prefix, const char* msg, va_list params) {
   char buffer[kBufferSize + 1];
   vsnprintf(buffer, kBufferSize, msg, params);
@@ -57,6 +79,29 @@ int Unreadable(const char* dir_file, char option) {
   return -1;
 }
 
+int Unsupported(const char* kernel, char option) {
+  Error("kernel \"%s\" is unknown or not supported by this processor for "
+        "-%c option.", kernel, option);
+  return -1;
+}
+
+int UnsupportedEngine(const char* engine, char option) {
+  Error("I/O engine \"%s\" is unknown or not supported by this system for "
+        "-%c option.", engine, option);
+  return -1;
+}
+
+int Unknown(const char* word) {
+  Error("unknown option \"%s\".", word);
+  printf(cdep_usage);
+  return -1;
+}
+
+int InvalidCount(const char* count, char option) {
+  Error("invalid count \"%s\" for -%c option.", count, option);
+  return -1;
+}
+
 const char* GetArg(int* i, int argc, const char* argv[]) {
   return 0 != argv[*i][2] ? argv[*i] + 2 :
          ++*i >= argc || '-' == argv[*i][0] ? "" : argv[*i];
@@ -73,6 +118,9 @@ int main(int argc, char** argv) {
   int file_count = 0;          // Record the number of files on the command line.
   bool read_from_file = false;      // -f<file> sets this to true.
   bool check_recursive = true;  // -x sets this to false.
+  bool skip_inactive = false;   // -c, -D<macro> and -U<macro> set this.
+  const char* cache_file = 0;   // --cache[=<file>] sets this.
+  bool no_cache = false;        // --no-cache sets this to true.
   idep::CompileDep compile_dep;
   for (int i = 1; i < argc; ++i) {
     const char* word = argv[i];
@@ -111,18 +159,91 @@ int main(int argc, char** argv) {
         }
         break;
         case 'x': {
+          if (word[2])
+            return Extra(word + 2, option);
+
+          check_recursive = false;
+        }
+        break;
+        case 'K': {
           const char** p = (const char **)argv;
           const char* arg = GetArg(&i, argc, p);
-          if (*arg)
-            return Extra(arg, option);
+          if (!*arg)
+            return Missing("kernel", option);
 
-          check_recursive = false;
+          if (!idep::RowKernel::Select(arg))
+            return Unsupported(arg, option);
+        }
+        break;
+        case 'j': {
+          const char** p = (const char **)argv;
+          const char* arg = GetArg(&i, argc, p);
+          if (!*arg)
+            return Missing("threads", option);
+
+          char* end;
+          long threads = strtol(arg, &end, 10);
+          if (*end || threads < 0 || threads > 1024)
+            return InvalidCount(arg, option);
+
+          idep::Condensation::setNumThreads(threads);
+        }
+        break;
+        case 'c': {
+          if (word[2])
+            return Extra(word + 2, option);
+
+          skip_inactive = true;
+        }
+        break;
+        case 'D': {
+          const char** p = (const char **)argv;
+          const char* arg = GetArg(&i, argc, p);
+          if (!*arg)
+            return Missing("macro", option);
+
+          compile_dep.DefineMacro(arg);
+          skip_inactive = true;
+        }
+        break;
+        case 'U': {
+          const char** p = (const char **)argv;
+          const char* arg = GetArg(&i, argc, p);
+          if (!*arg)
+            return Missing("macro", option);
+
+          compile_dep.UndefineMacro(arg);
+          skip_inactive = true;
+        }
+        break;
+        case 'a': {
+          const char** p = (const char **)argv;
+          const char* arg = GetArg(&i, argc, p);
+          if (!*arg)
+            return Missing("engine", option);
+
+          idep::FileLoader::Engine engine;
+          if (!idep::FileLoader::Find(arg, &engine) ||
+              !idep::FileLoader::IsSupported(engine))
+            return UnsupportedEngine(arg, option);
+
+          compile_dep.SetAsynchronousLoading(true, engine);
+        }
+        break;
+        case '-': {
+          if (0 == strcmp(word, "--cache")) {
+            cache_file = kDefaultCacheFile;
+          } else if (0 == strncmp(word, "--cache=", 8) && word[8]) {
+            cache_file = word + 8;
+          } else if (0 == strcmp(word, "--no-cache")) {
+            no_cache = true;
+          } else {
+            return Unknown(word);
+          }
         }
         break;
         default: {
-          Error("unknown option \"%s\".", word);
-          printf(cdep_usage);
-          return -1;
+          return Unknown(word);
         }
         break;
       }
@@ -135,10 +256,18 @@ int main(int argc, char** argv) {
   if (!read_from_file && !file_count)
     compile_dep.InputRootFiles();
 
+  compile_dep.SetSkipInactiveIncludes(skip_inactive);
+
+  compile_dep.SetCacheFile(no_cache ? 0 : cache_file);
+
   int status = 0;
   if (!compile_dep.Calculate(std::cerr, check_recursive))
     status = -1;
 
+  if (skip_inactive)
+    fprintf(stderr, "cdep: %d inactive include directive(s) skipped.\n",
+            compile_dep.NumSkippedIncludes());
+
   std::cout << compile_dep;
 
   return status;
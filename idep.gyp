@@ -15,19 +15,41 @@
         'idep_alias_util.h',
         'idep_binary_relation.cc',
         'idep_binary_relation.h',
+        'idep_char_scan.cc',
+        'idep_char_scan.h',
         'idep_compile_dep.cc',
         'idep_compile_dep.h',
+        'idep_condensation.cc',
+        'idep_condensation.h',
         'idep_file_dep_iterator.cc',
         'idep_file_dep_iterator.h',
+        'idep_file_loader.cc',
+        'idep_file_loader.h',
         'idep_link_dep.cc',
         'idep_link_dep.h',
+        'idep_macro_table.cc',
+        'idep_macro_table.h',
         'idep_name_array.cc',
         'idep_name_array.h',
         'idep_name_index_map.cc',
         'idep_name_index_map.h',
+        'idep_row_kernel.cc',
+        'idep_row_kernel.h',
+        'idep_scan_cache.cc',
+        'idep_scan_cache.h',
+        'idep_sparse_relation.cc',
+        'idep_sparse_relation.h',
+        'idep_strong_components.h',
+        'idep_thread_team.cc',
+        'idep_thread_team.h',
         'idep_token_iterator.cc',
         'idep_token_iterator.h',
       ],
+      'link_settings': {
+        'libraries': [
+          '-lpthread',
+        ],
+      },
     },
     {
       'target_name': 'adep',
@@ -39,6 +61,66 @@
         'adep.cc',
       ],
     },
+    {
+      'target_name': 'idep_binary_relation_test',
+      'type': 'executable',
+      'dependencies': [
+        'idep',
+      ],
+      'sources': [
+        'idep_binary_relation_test.cc',
+      ],
+    },
+    {
+      'target_name': 'idep_condensation_test',
+      'type': 'executable',
+      'dependencies': [
+        'idep',
+      ],
+      'sources': [
+        'idep_condensation_test.cc',
+      ],
+    },
+    {
+      'target_name': 'idep_file_dep_iterator_test',
+      'type': 'executable',
+      'dependencies': [
+        'idep',
+      ],
+      'sources': [
+        'idep_file_dep_iterator_test.cc',
+      ],
+    },
+    {
+      'target_name': 'idep_file_loader_test',
+      'type': 'executable',
+      'dependencies': [
+        'idep',
+      ],
+      'sources': [
+        'idep_file_loader_test.cc',
+      ],
+    },
+    {
+      'target_name': 'idep_link_dep_test',
+      'type': 'executable',
+      'dependencies': [
+        'idep',
+      ],
+      'sources': [
+        'idep_link_dep_test.cc',
+      ],
+    },
+    {
+      'target_name': 'idep_scan_cache_test',
+      'type': 'executable',
+      'dependencies': [
+        'idep',
+      ],
+      'sources': [
+        'idep_scan_cache_test.cc',
+      ],
+    },
     {
       'target_name': 'cdep',
       'type': 'executable',
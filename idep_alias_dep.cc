@@ -2,17 +2,18 @@
 
 #include <assert.h>
 #include <ctype.h>      // isascii() isspace()
-#include <memory.h>     // memcpy()
+#include <memory.h>     // memcmp()
 #include <string.h>     // strlen() strrchr()
 
 #include <fstream>
 #include <iostream>
+#include <string>
 
 #include "idep_alias_table.h"
 #include "idep_alias_util.h"
-#include "idep_file_dep_iterator.h"
 #include "idep_name_array.h"
 #include "idep_name_index_map.h"
+#include "idep_scan_cache.h"
 #include "idep_token_iterator.h"
 
 namespace idep {
@@ -89,20 +90,22 @@ static int loadFromFile(const char *file, AliasDep *dep, Func add)
     return GOOD;
 }
 
-static char* NewStrCpy(const char* old_str) {
-  int size = strlen(old_str) + 1;
-  char* new_str = new char[size];
-  memcpy(new_str, old_str, size);
-  return new_str;
+static int removeSuffix(const char *dirPath)
+{
+    // Return the length of the specified path without the suffix, if any,
+    // of its final segment ("a/b.c" -> "a/b", "a/.b" -> "a/").
+    int length = strlen(dirPath);
+    for (int i = length - 1; i >= 0 && '/' != dirPath[i]; --i) {
+        if ('.' == dirPath[i]) {
+            return i;
+        }
+    }
+    return length;
 }
 
-static char *removeSuffix(char *dirPath)
+static int sameName(const char *a, int aLength, const char *b, int bLength)
 {
-    char *dot = strrchr(dirPath, '.');
-    if (dot && !strchr(dot, '/')) {     // if '.' found in final path segment
-        dot[0] = '\0';                  // eliminate suffix ("a/.b" -> "a/")
-    }
-    return dirPath;
+    return aLength == bLength && 0 == memcmp(a, b, aLength);
 }
 
                 // -*-*-*- AliasDepIntArray -*-*-*-
@@ -127,24 +130,40 @@ static void zero(AliasDepIntArray *a) // non-primitive operation on array
     }
 }
 
-                // -*-*-*- AliasDepString -*-*-*-
-
-class AliasDepString {     // auxiliary class to manage modifiable char *
-    char *d_string_p;
-    AliasDepString(const AliasDepString&);
-    AliasDepString& operator=(const AliasDepString&);
-  public:
-    AliasDepString(const char *s) : d_string_p(NewStrCpy(s)){}
-    ~AliasDepString() { delete [] d_string_p; }
-    operator char *() { return d_string_p; }
-};
-
 struct AliasDepImpl {
     NameIndexMap d_ignoreNames;          // e.g., idep_compile_dep_unittest.cc
     AliasTable d_aliases;                // e.g., my_inta -> my_intarray
     NameIndexMap d_fileNames;            // files to be analyzed
+    std::string d_cacheFile;             // empty if not caching
+
+    // Load the cache file, if any, into the specified cache and return
+    // the cache, or 0 if there is no cache file.
+    ScanCache *loadCache(ScanCache *cache, std::ostream& orf) const;
+
+    // Save the specified cache, if any, to the cache file.
+    void saveCache(const ScanCache *cache, std::ostream& orf) const;
 };
 
+ScanCache *AliasDepImpl::loadCache(ScanCache *cache, std::ostream& orf) const
+{
+    if (d_cacheFile.empty()) {
+        return 0;
+    }
+    if (!cache->Load(d_cacheFile.c_str())) {
+        warn(orf) << "ignoring invalid cache file \"" << d_cacheFile
+                  << "\"." << std::endl;
+    }
+    return cache;
+}
+
+void AliasDepImpl::saveCache(const ScanCache *cache, std::ostream& orf) const
+{
+    if (cache && !cache->Save(d_cacheFile.c_str())) {
+        warn(orf) << "unable to write cache file \"" << d_cacheFile
+                  << "\"." << std::endl;
+    }
+}
+
                 // -*-*-*- AliasDep -*-*-*-
 
 AliasDep::AliasDep()
@@ -167,8 +186,10 @@ int AliasDep::readIgnoreNames(const char *file) {
 }
 
 const char *AliasDep::addAlias(const char *alias, const char *component) {
-  return impl_->d_aliases.Add(alias, component) < 0 ?
-      impl_->d_aliases.Lookup(alias) : 0;
+  const char *previous;
+  return impl_->d_aliases.Add(alias, strlen(alias),
+                              component, strlen(component), &previous) < 0 ?
+      previous : 0;
 }
 
 int AliasDep::readAliases(std::ostream& orf, const char *file)
@@ -181,6 +202,11 @@ void AliasDep::addFileName(const char *fileName)
     impl_->d_fileNames.Add(fileName);
 }
 
+void AliasDep::setCacheFile(const char *fileName)
+{
+    impl_->d_cacheFile = fileName ? fileName : "";
+}
+
 int AliasDep::readFileNames(const char *file) {
   return loadFromFile(file, this, &AliasDep::addFileName);
 }
@@ -202,23 +228,22 @@ int AliasDep::unpaired(std::ostream& out, std::ostream& ing, int suffixFlag) con
     NameIndexMap components;
     int numComponents = 0;
 
+    impl_->d_ignoreNames.Freeze();      // only looked up from here on
+
     NameIndexMap printNames;   // Used to sort names for ease of use
                                // during cut and past in the editor.
 
     for (int i = 0; i < maxLength; ++i) {
-        AliasDepString s(impl_->d_fileNames[i]);
+        const char *s = impl_->d_fileNames[i];
 
         if (impl_->d_ignoreNames.GetIndexByName(s) >= 0) {
             continue; // ignore this file
         }
-        removeSuffix(s);
-
-        const char *componentName = impl_->d_aliases.Lookup(s);
-        if (!componentName) {
-            componentName = s;
-        }
+        int length = removeSuffix(s);
 
-        int componentIndex = components.Entry(componentName);
+        const char *componentName = impl_->d_aliases.Lookup(s, length);
+        int componentIndex = componentName ? components.Entry(componentName)
+                                           : components.Entry(s, length);
         if (components.Length() > numComponents) {      // new component
             ++numComponents;
 
@@ -297,43 +322,49 @@ int AliasDep::verify(std::ostream& orf) const
     enum { IOERROR = -1, GOOD = 0 } status = GOOD;
     int errorCount = 0; // keep track of the number of readable faulty files
 
+    impl_->d_ignoreNames.Freeze();      // only looked up from here on
+
+    ScanCache cache("");
+    ScanCache *cache_p = impl_->loadCache(&cache, orf);
+
     int length = impl_->d_fileNames.Length();
     for (int i = 0; i < length; ++i) {
         const char *path = impl_->d_fileNames[i];
-        AliasDepString c(path);
 
-        if (impl_->d_ignoreNames.GetIndexByName(c) >= 0) {
+        if (impl_->d_ignoreNames.GetIndexByName(path) >= 0) {
             continue; // ignore this file
         }
 
         // strip off suffix and path from component file name and check aliases
-        removeSuffix(c);
-        const char *actualComponent = stripDir(c);
-
-	char temp[355];
-	//	#= actualComponent;
-	strcpy (temp,actualComponent);
-        const char *compAlias = impl_->d_aliases.Lookup(temp);
-
-        const char *component = compAlias ? compAlias : actualComponent;
+        const char *component = stripDir(path);
+        int componentLength = removeSuffix(component);
+        const char *compAlias = impl_->d_aliases.Lookup(component,
+                                                        componentLength);
+        if (compAlias) {
+            component = compAlias;
+            componentLength = strlen(compAlias);
+        }
 
         int directiveIndex = 0;
 
-	FileDepIterator it(path);
+        ScanCacheIterator it(cache_p, path);
 
         for (it; it; ++it) {
 
             ++directiveIndex;
 
             // strip off suffix and path from header name and check aliases
-            AliasDepString h(it());
-            removeSuffix(h);
-            const char *actualHeader = stripDir(h);
-            const char *headerAlias = impl_->d_aliases.Lookup(actualHeader);
-            const char *header = headerAlias ? headerAlias : actualHeader;
-
-            if (0 == strcmp(component, header)) { // if the same, we found it
-                break;
+            const char *header = stripDir(it());
+            int headerLength = removeSuffix(header);
+            const char *headerAlias = impl_->d_aliases.Lookup(header,
+                                                              headerLength);
+            if (headerAlias) {
+                header = headerAlias;
+                headerLength = strlen(headerAlias);
+            }
+
+            if (sameName(component, componentLength, header, headerLength)) {
+                break;                  // if the same, we found it
             }
         }
 
@@ -359,6 +390,8 @@ int AliasDep::verify(std::ostream& orf) const
         // else there is nothing wrong here
     }
 
+    impl_->saveCache(cache_p, orf);
+
     return status == GOOD ? errorCount : status;
 }
 
@@ -369,6 +402,11 @@ int AliasDep::extract(std::ostream& out, std::ostream& orf) const
     enum { INVALID_INDEX = -1 };
     int errorCount = 0; // keep track of number of readable faulty files
 
+    impl_->d_ignoreNames.Freeze();      // only looked up from here on
+
+    ScanCache cache("");
+    ScanCache *cache_p = impl_->loadCache(&cache, orf);
+
     NameIndexMap uniqueHeaders;       // used to detect multiple .c files
     int length = impl_->d_fileNames.Length();
     AliasDepIntArray hits(length);    // records frequency of headers
@@ -381,19 +419,22 @@ int AliasDep::extract(std::ostream& out, std::ostream& orf) const
         hmap[i] = INVALID_INDEX;   // set valid when a suitable header is found
 
         const char *path = impl_->d_fileNames[i];
-        AliasDepString c(path);
 
-        if (impl_->d_ignoreNames.GetIndexByName(c) >= 0) {
+        if (impl_->d_ignoreNames.GetIndexByName(path) >= 0) {
             continue; // ignore this file
         }
 
         // strip off suffix and path from component file name and check aliases
-        removeSuffix(c);
-        const char *actualComponent = stripDir(c);
-        const char *compAlias = impl_->d_aliases.Lookup(actualComponent);
-        const char *component = compAlias ? compAlias : actualComponent;
+        const char *component = stripDir(path);
+        int componentLength = removeSuffix(component);
+        const char *compAlias = impl_->d_aliases.Lookup(component,
+                                                        componentLength);
+        if (compAlias) {
+            component = compAlias;
+            componentLength = strlen(compAlias);
+        }
 
-        FileDepIterator it(path);      // hook up with first dependency.
+        ScanCacheIterator it(cache_p, path);  // hook up with first dependency.
 
         if (!it.IsValidFile()) {        // unable to read file
             err(orf) << "unable to open file \""
@@ -410,13 +451,15 @@ int AliasDep::extract(std::ostream& out, std::ostream& orf) const
         }
 
         // strip off suffix and path from header name and check aliases
-        AliasDepString h(it());
-        removeSuffix(h);
-        const char *actualHeader = stripDir(h);
-        const char *headerAlias = impl_->d_aliases.Lookup(actualHeader);
-        const char *header = headerAlias ? headerAlias : actualHeader;
+        const char *header = stripDir(it());
+        int headerLength = removeSuffix(header);
+        const char *headerAlias = impl_->d_aliases.Lookup(header, headerLength);
+        if (headerAlias) {
+            header = headerAlias;
+            headerLength = strlen(headerAlias);
+        }
 
-        if (0 == strcmp(component, header)) {
+        if (sameName(component, componentLength, header, headerLength)) {
 
             // At this point, we have the component name and header name
             // that match either because the root names were matching or
@@ -440,7 +483,7 @@ int AliasDep::extract(std::ostream& out, std::ostream& orf) const
         // We have no reason *not* to think this is a valid match (yet).
         // Record this header as being associated with the this .c file.
 
-        int hIndex = uniqueHeaders.Entry(header); // obtaine index of header
+        int hIndex = uniqueHeaders.Entry(header, headerLength); // its index
         ++hits[hIndex];                           // record frequency
         hmap[i] = hIndex;                         // set .c -> header index
     }
@@ -473,12 +516,14 @@ int AliasDep::extract(std::ostream& out, std::ostream& orf) const
     for (int i = 0; i < length; ++i) {
         if (hmap[i] >= 0 && !verified[i]) {
            // strip off suffix and path from component file name
-           AliasDepString c(impl_->d_fileNames[i]);
-           removeSuffix(c);
-           out << uniqueHeaders[hmap[i]] << ' ' << c << std::endl;
+           const char *c = impl_->d_fileNames[i];
+           out << uniqueHeaders[hmap[i]] << ' ';
+           out.write(c, removeSuffix(c)) << std::endl;
         }
     }
 
+    impl_->saveCache(cache_p, orf);
+
     return status == GOOD ? errorCount : status;
 }
 
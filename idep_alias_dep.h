@@ -51,6 +51,13 @@ class AliasDep {
   // function.
   int readAliases(std::ostream& err, const char *file);
 
+  // Specify the file in which to keep the include directives found in
+  // each file from one run to the next, so that a file need not be
+  // scanned again until it changes; 0 (the default) for none.  The cache
+  // file is read at the start of verify() and extract() and rewritten at
+  // the end if anything was added to it.
+  void setCacheFile(const char *fileName);
+
   // Add the name of a file to be analyzed.  Errors in reading this file
   // will be detected only when a processing operation is invoked.
   void addFileName(const char *fileName);
@@ -1,103 +1,615 @@
 #include "idep_alias_table.h"
 
 #include <assert.h>
-#include <memory.h>     // memcpy()
-#include <string.h>     // strcmp() strlen()
+#include <memory.h>     // memcpy() memset()
+#include <string.h>     // strlen()
 
+#include <algorithm>    // sort()
 #include <iostream>
+#include <string>
+
+#include "idep_name_index_map.h"
+
+// IMPLEMENTATION NOTE: Aliases and original names live in two separate
+// NameIndexMaps, so each distinct original name is stored only once no
+// matter how many aliases map to it.  The alias with index i maps to the
+// original name with index d_targets_p[i]:
+//
+//   d_aliases:     0 "fooa"     1 "foob"     2 "barx"
+//   d_targets_p:   [    0     |     0      |     1     ]
+//   d_originals:   0 "fooarray"              1 "bar"
+//
+// Each pattern alias (a "rule") is translated into a sequence of
+// elements, each matching either one character of a set or ('*') any
+// number of characters, followed by an ACCEPT element.  The elements of
+// all rules are kept in one array, and a position in that array is a
+// state of a nondeterministic automaton that matches all rules at once.
+// E.g., for the rules "*_impl" (0) and "src/?" (1):
+//
+//   element:   0    1    2    3    4    5    6    7    8    9   10   11
+//   rule 0:   '*'  '_'  'i'  'm'  'p'  'l'  ACC
+//   rule 1:                                     's'  'r'  'c'  '/'  '?'  ACC
+//
+// A deterministic automaton is derived from it as names are resolved:
+// each of its states is a set of positions, interned in d_states_p under
+// a key such as "0,1,7," and given a row of NUM_CHARS successors that
+// are filled in as characters are first seen in that state.  A state
+// accepts the lowest-numbered rule whose ACCEPT element it contains, so
+// the rule added first wins.  Whatever a name resolves to is memoized in
+// d_resolved_p; adding a rule discards both.  Neither may grow without
+// bound: once MAX_RESOLVED names are memoized, the memo is discarded and
+// begun again, and likewise the automaton once it has MAX_STATES states,
+// so that looking up ever more distinct names takes bounded memory.
 
 namespace {
 
-enum { DEFAULT_TABLE_SIZE = 521 };
+enum { START_SIZE = 16, GROW_FACTOR = 2 };
+enum { NUM_CHARS = 256, SET_SIZE = NUM_CHARS / 8 };
+enum { DEAD_STATE = 0, START_STATE = 1, UNKNOWN = -1 };
+enum { NO_RULE = -1, NO_NAME = -1 };
+enum { MAX_RESOLVED = 1 << 16, MAX_STATES = 1 << 12 };
+enum { FOUND_DIFFERENT = -1, NOT_FOUND = 0, FOUND_IDENTICAL = 1 };
+
+enum ElementKind {
+    SET,                // any one character in d_set
+    STAR,               // any sequence of characters
+    ACCEPT              // end of rule d_rule
+};
 
-unsigned hash(register const char* name) {
-    register unsigned sum = 1000003; // 1,000,003 is the 78,498th prime number
-    while (*name) {
-        sum *= *name++; // integer multiplication is a subroutine on a SPARC
+struct PatternElement {
+    ElementKind d_kind;
+    int d_rule;                         // rule ended by an ACCEPT element
+    unsigned char d_set[SET_SIZE];      // bit c is set if c matches
+};
+
+int* resize(int* array, int length, int size) {
+  int* tmp = new int[size];
+  memcpy(tmp, array, length * sizeof *tmp);
+  delete[] array;
+  return tmp;
+}
+
+inline int inSet(const unsigned char* set, unsigned char c) {
+  return set[c >> 3] & 1 << (c & 7);
+}
+
+int parseClass(const char* p, const char* end, unsigned char* set) {
+  // Load into the specified set the characters matched by the bracketed
+  // class whose opening '[' immediately precedes the specified position,
+  // and return the number of characters after the '[' up to and including
+  // the closing ']', or 0 if the class is not terminated.
+  const char* q = p;
+  const int negate = q < end && ('!' == *q || '^' == *q);
+  if (negate)
+    ++q;
+  const char* first = q;
+  memset(set, 0, SET_SIZE);
+  while (q < end && (']' != *q || q == first)) {
+    const unsigned char lo = *q;
+    unsigned char hi = lo;
+    if (q + 2 < end && '-' == q[1] && ']' != q[2]) {
+      hi = q[2];
+      q += 3;
+    } else {
+      ++q;
     }
-    return sum; // unsigned ensures positive value for use with (%) operator.
+    for (int c = lo; c <= hi; ++c)
+      set[c >> 3] |= 1 << (c & 7);
+  }
+  if (q >= end)
+    return 0;
+  if (negate) {
+    for (int i = 0; i < SET_SIZE; ++i)
+      set[i] = ~set[i];
+  }
+  return q + 1 - p;
 }
 
-char* NewStrCpy(const char* old_str) {
-  int size = strlen(old_str) + 1;
-  char* new_str = new char[size];
-  assert(new_str);
-  memcpy(new_str, old_str, size);
-  return new_str;
+int isPattern(const char* name, int length) {
+  unsigned char set[SET_SIZE];
+  const char* end = name + length;
+  for (const char* p = name; p < end; ++p) {
+    if ('*' == *p || '?' == *p || ('[' == *p && parseClass(p + 1, end, set)))
+      return 1;
+  }
+  return 0;
+}
+
+int compile(const char* pattern, int length, PatternElement* elements) {
+  // Translate the specified pattern into elements, not including its
+  // ACCEPT element, and return their number (at most length).
+  const char* end = pattern + length;
+  int n = 0;
+  for (const char* p = pattern; p < end; ++n) {
+    PatternElement& e = elements[n];
+    int k;
+    if ('*' == *p) {
+      e.d_kind = STAR;
+      ++p;
+    } else if ('?' == *p) {
+      e.d_kind = SET;
+      memset(e.d_set, 0xff, SET_SIZE);
+      ++p;
+    } else if ('[' == *p && (k = parseClass(p + 1, end, e.d_set))) {
+      e.d_kind = SET;
+      p += 1 + k;
+    } else {
+      const unsigned char c = *p++;
+      e.d_kind = SET;
+      memset(e.d_set, 0, SET_SIZE);
+      e.d_set[c >> 3] |= 1 << (c & 7);
+    }
+  }
+  return n;
+}
+
+void appendNumber(std::string* s, int n) {
+  char digits[16];
+  int i = sizeof digits;
+  do {
+    digits[--i] = '0' + n % 10;
+    n /= 10;
+  } while (n > 0);
+  s->append(digits + i, sizeof digits - i);
 }
 
 }  // namespace
 
 namespace idep {
 
-struct AliasTableLink {
-  char* d_alias_p;                       // "from" (alias) name
-  char* d_originalName_p;                // "to" (original) name
-  AliasTableLink* d_next_p;              // pointer to next link
+struct AliasTableImpl {
+  NameIndexMap d_aliases;       // "from" (alias) names
+  NameIndexMap d_originals;     // distinct "to" (original) names
+  int* d_targets_p;             // original name index of each alias
+  int d_size;                   // physical size of d_targets_p
+
+  NameIndexMap d_patterns;      // pattern aliases, one rule each
+  int* d_ruleTargets_p;         // original name index of each rule
+  int* d_ruleStarts_p;          // first element of each rule
+  int d_ruleSize;               // physical size of the rule arrays
+  PatternElement* d_elements_p; // elements of all rules
+  int d_numElements;
+  int d_elementSize;            // physical size of d_elements_p
+
+  NameIndexMap* d_states_p;     // positions of each state, or 0 if unbuilt
+  int* d_next_p;                // successor of state s on character c at
+                                // NUM_CHARS * s + c, or UNKNOWN
+  int* d_winners_p;             // rule accepted by each state, or NO_RULE
+  int d_stateSize;              // physical size of the state arrays
+  int* d_marks_p;               // last d_stamp each position was added at
+  int d_stamp;
+  int* d_from_p;                // positions of the state being left
+  int* d_to_p;                  // positions of the state being entered
+
+  NameIndexMap* d_resolved_p;   // names matched against the rules so far
+  int* d_resolutions_p;         // original name index of each, or NO_NAME
+  int d_resolvedSize;           // physical size of d_resolutions_p
+
+  explicit AliasTableImpl(int size_hint);
+  ~AliasTableImpl();
+
+  // Make room in d_targets_p for at least the specified number of aliases.
+  void reserve(int num_aliases);
+
+  // Add the specified pattern as a rule mapping to the specified original
+  // name; return as AliasTable::Add does.
+  int addRule(const char* pattern, int pattern_length,
+              const char* original_name, int original_name_length,
+              const char** previous_name);
+
+  // Discard the deterministic automaton and all resolved names.
+  void reset();
+
+  // Discard all resolved names.
+  void forget();
 
-  AliasTableLink(const char* alias,
-                 const char* original_name,
-                 AliasTableLink* next);
-  ~AliasTableLink();
+  // Build the dead and start states of the deterministic automaton.
+  void build();
+
+  // Add the specified position and those reachable from it by skipping
+  // STAR elements to d_to_p, which holds the specified number of
+  // positions, unless they were already added at the current d_stamp.
+  void addClosure(int position, int* n);
+
+  // Return the state for the specified (sorted) positions, creating it
+  // if needed.
+  int state(const int* positions, int n);
+
+  // Compute, record and return the successor of the specified state on
+  // the specified character.
+  int step(int state, unsigned char c);
+
+  // Return the first rule that matches the whole of the specified name,
+  // or NO_RULE if none does.
+  int match(const char* name, int length);
+
+  // Return the original name index that the specified rule maps the
+  // specified name, which it matches, to.
+  int expand(int rule, const char* name, int length);
+
+  // Return the original name index that the first matching rule maps
+  // the specified name to, or NO_NAME if no rule matches it.
+  int resolve(const char* name, int length);
 };
 
-AliasTableLink::AliasTableLink(const char* alias,
-                               const char* original_name,
-                               AliasTableLink* next)
-    : d_alias_p(NewStrCpy(alias)),
-      d_originalName_p(NewStrCpy(original_name)),
-      d_next_p(next) {
+AliasTableImpl::AliasTableImpl(int size_hint)
+    : d_aliases(size_hint),
+      d_originals(size_hint),
+      d_size(size_hint > START_SIZE ? size_hint : START_SIZE),
+      d_ruleSize(START_SIZE),
+      d_numElements(0),
+      d_elementSize(START_SIZE),
+      d_states_p(0),
+      d_next_p(0),
+      d_winners_p(0),
+      d_stateSize(0),
+      d_marks_p(0),
+      d_stamp(0),
+      d_from_p(0),
+      d_to_p(0),
+      d_resolved_p(0),
+      d_resolutions_p(0),
+      d_resolvedSize(0) {
+  d_targets_p = new int[d_size];
+  d_ruleTargets_p = new int[d_ruleSize];
+  d_ruleStarts_p = new int[d_ruleSize];
+  d_elements_p = new PatternElement[d_elementSize];
 }
 
-AliasTableLink::~AliasTableLink()  {
-  delete[] d_alias_p;
-  delete[] d_originalName_p;
+AliasTableImpl::~AliasTableImpl() {
+  reset();
+  delete[] d_targets_p;
+  delete[] d_ruleTargets_p;
+  delete[] d_ruleStarts_p;
+  delete[] d_elements_p;
+}
+
+void AliasTableImpl::reserve(int num_aliases) {
+  if (num_aliases <= d_size)
+    return;
+  int size = d_size;
+  while (size < num_aliases)
+    size *= GROW_FACTOR;
+  d_targets_p = resize(d_targets_p, d_aliases.Length(), size);
+  d_size = size;
+}
+
+int AliasTableImpl::addRule(const char* pattern, int pattern_length,
+                            const char* original_name,
+                            int original_name_length,
+                            const char** previous_name) {
+  const int numRules = d_patterns.Length();
+  const int rule = d_patterns.Entry(pattern, pattern_length);
+  if (d_patterns.Length() == numRules) {
+    const int target = d_ruleTargets_p[rule];
+    *previous_name = d_originals[target];
+    return target == d_originals.GetIndexByName(original_name,
+                                                original_name_length)
+           ? FOUND_IDENTICAL
+           : FOUND_DIFFERENT;
+  }
+
+  if (rule >= d_ruleSize) {
+    const int size = d_ruleSize * GROW_FACTOR;
+    d_ruleTargets_p = resize(d_ruleTargets_p, numRules, size);
+    d_ruleStarts_p = resize(d_ruleStarts_p, numRules, size);
+    d_ruleSize = size;
+  }
+  if (d_numElements + pattern_length + 1 > d_elementSize) {
+    int size = d_elementSize;
+    while (size < d_numElements + pattern_length + 1)
+      size *= GROW_FACTOR;
+    PatternElement* tmp = d_elements_p;
+    d_elements_p = new PatternElement[size];
+    memcpy(d_elements_p, tmp, d_numElements * sizeof *tmp);
+    delete[] tmp;
+    d_elementSize = size;
+  }
+
+  d_ruleTargets_p[rule] = d_originals.Entry(original_name,
+                                            original_name_length);
+  d_ruleStarts_p[rule] = d_numElements;
+  d_numElements += compile(pattern, pattern_length,
+                           d_elements_p + d_numElements);
+  d_elements_p[d_numElements].d_kind = ACCEPT;
+  d_elements_p[d_numElements].d_rule = rule;
+  ++d_numElements;
+
+  reset();
+  *previous_name = 0;
+  return NOT_FOUND;
+}
+
+void AliasTableImpl::reset() {
+  delete d_states_p;
+  delete[] d_next_p;
+  delete[] d_winners_p;
+  delete[] d_marks_p;
+  delete[] d_from_p;
+  delete[] d_to_p;
+  d_states_p = 0;
+  d_next_p = 0;
+  d_winners_p = 0;
+  d_stateSize = 0;
+  d_marks_p = 0;
+  d_from_p = 0;
+  d_to_p = 0;
+  forget();
+}
+
+void AliasTableImpl::forget() {
+  delete d_resolved_p;
+  delete[] d_resolutions_p;
+  d_resolved_p = 0;
+  d_resolutions_p = 0;
+  d_resolvedSize = 0;
+}
+
+void AliasTableImpl::build() {
+  d_states_p = new NameIndexMap;
+  d_stateSize = START_SIZE;
+  d_next_p = new int[NUM_CHARS * d_stateSize];
+  d_winners_p = new int[d_stateSize];
+  d_marks_p = new int[d_numElements];
+  memset(d_marks_p, 0, d_numElements * sizeof *d_marks_p);
+  d_stamp = 0;
+  d_from_p = new int[d_numElements];
+  d_to_p = new int[d_numElements];
+
+  int dead = state(d_to_p, 0);
+  assert(DEAD_STATE == dead);
+
+  int n = 0;
+  ++d_stamp;
+  for (int rule = 0; rule < d_patterns.Length(); ++rule)
+    addClosure(d_ruleStarts_p[rule], &n);
+  std::sort(d_to_p, d_to_p + n);
+  int start = state(d_to_p, n);
+  assert(START_STATE == start);
+}
+
+void AliasTableImpl::addClosure(int position, int* n) {
+  for (;;) {
+    if (d_marks_p[position] != d_stamp) {
+      d_marks_p[position] = d_stamp;
+      d_to_p[(*n)++] = position;
+    }
+    if (STAR != d_elements_p[position].d_kind)
+      return;
+    ++position;
+  }
+}
+
+int AliasTableImpl::state(const int* positions, int n) {
+  std::string key;
+  for (int i = 0; i < n; ++i) {
+    appendNumber(&key, positions[i]);
+    key += ',';
+  }
+
+  const int numStates = d_states_p->Length();
+  const int s = d_states_p->Entry(key.data(), key.size());
+  if (d_states_p->Length() > numStates) {
+    if (s >= d_stateSize) {
+      const int size = d_stateSize * GROW_FACTOR;
+      d_next_p = resize(d_next_p, NUM_CHARS * numStates, NUM_CHARS * size);
+      d_winners_p = resize(d_winners_p, numStates, size);
+      d_stateSize = size;
+    }
+    for (int c = 0; c < NUM_CHARS; ++c)
+      d_next_p[NUM_CHARS * s + c] = UNKNOWN;
+
+    // Rules occupy ascending positions, so the first ACCEPT element found
+    // ends the lowest-numbered rule.
+    d_winners_p[s] = NO_RULE;
+    for (int i = 0; i < n; ++i) {
+      if (ACCEPT == d_elements_p[positions[i]].d_kind) {
+        d_winners_p[s] = d_elements_p[positions[i]].d_rule;
+        break;
+      }
+    }
+  }
+  return s;
+}
+
+int AliasTableImpl::step(int s, unsigned char c) {
+  int numFrom = 0;
+  for (const char* p = (*d_states_p)[s]; *p; ++p) {
+    int position = 0;
+    while (',' != *p)
+      position = 10 * position + (*p++ - '0');
+    d_from_p[numFrom++] = position;
+  }
+
+  int n = 0;
+  ++d_stamp;
+  for (int i = 0; i < numFrom; ++i) {
+    const int position = d_from_p[i];
+    const PatternElement& e = d_elements_p[position];
+    if (STAR == e.d_kind) {
+      addClosure(position, &n);
+    } else if (SET == e.d_kind && inSet(e.d_set, c)) {
+      addClosure(position + 1, &n);
+    }
+  }
+  std::sort(d_to_p, d_to_p + n);
+
+  const int t = state(d_to_p, n);
+  d_next_p[NUM_CHARS * s + c] = t;
+  return t;
+}
+
+int AliasTableImpl::match(const char* name, int length) {
+  if (!d_states_p)
+    build();
+
+  int s = START_STATE;
+  for (const char* end = name + length; name < end && DEAD_STATE != s;
+       ++name) {
+    const unsigned char c = *name;
+    const int t = d_next_p[NUM_CHARS * s + c];
+    s = UNKNOWN != t ? t : step(s, c);
+  }
+  return d_winners_p[s];
+}
+
+int AliasTableImpl::expand(int rule, const char* name, int length) {
+  const int target = d_ruleTargets_p[rule];
+  const char* original = d_originals[target];
+  if (!strchr(original, '*'))
+    return target;
+
+  // Find the text matched by each '*' of the rule, taking as little as
+  // possible for each from left to right: on a mismatch, the most
+  // recent '*' takes one more character and matching resumes after it.
+
+  const PatternElement* start = d_elements_p + d_ruleStarts_p[rule];
+  int numStars = 0;
+  for (const PatternElement* e = start; ACCEPT != e->d_kind; ++e)
+    numStars += STAR == e->d_kind;
+  int* begins = new int[numStars + 1];
+  int* ends = new int[numStars + 1];
+
+  const PatternElement* e = start;
+  const PatternElement* lastStar = 0;
+  int i = 0;
+  int k = 0;
+  for (;;) {
+    if (STAR == e->d_kind) {
+      begins[k] = ends[k] = i;
+      lastStar = e++;
+      ++k;
+    } else if (ACCEPT == e->d_kind && i == length) {
+      break;
+    } else if (SET == e->d_kind && i < length && inSet(e->d_set, name[i])) {
+      ++e;
+      ++i;
+    } else {
+      assert(lastStar);         // the rule is known to match
+      int star = 0;
+      for (const PatternElement* p = start; p < lastStar; ++p)
+        star += STAR == p->d_kind;
+      assert(ends[star] < length);
+      i = ++ends[star];
+      e = lastStar + 1;
+      k = star + 1;
+    }
+  }
+
+  // Replace each '*' of the original name by the corresponding text.
+
+  std::string result;
+  k = 0;
+  for (const char* p = original; *p; ++p) {
+    if ('*' == *p && k < numStars) {
+      result.append(name + begins[k], ends[k] - begins[k]);
+      ++k;
+    } else {
+      result += *p;
+    }
+  }
+  delete[] begins;
+  delete[] ends;
+
+  return d_originals.Entry(result.data(), result.size());
+}
+
+int AliasTableImpl::resolve(const char* name, int length) {
+  if (d_states_p && d_states_p->Length() >= MAX_STATES)
+    reset();
+  else if (d_resolved_p && d_resolved_p->Length() >= MAX_RESOLVED)
+    forget();
+
+  if (!d_resolved_p) {
+    d_resolved_p = new NameIndexMap;
+    d_resolvedSize = START_SIZE;
+    d_resolutions_p = new int[d_resolvedSize];
+  }
+
+  const int numResolved = d_resolved_p->Length();
+  const int index = d_resolved_p->Entry(name, length);
+  if (d_resolved_p->Length() > numResolved) {
+    if (index >= d_resolvedSize) {
+      const int size = d_resolvedSize * GROW_FACTOR;
+      d_resolutions_p = resize(d_resolutions_p, numResolved, size);
+      d_resolvedSize = size;
+    }
+    const int rule = match(name, length);
+    d_resolutions_p[index] = NO_RULE == rule ? NO_NAME
+                                             : expand(rule, name, length);
+  }
+  return d_resolutions_p[index];
 }
 
 AliasTable::AliasTable(int size)
-    : size_(size > 0 ? size : DEFAULT_TABLE_SIZE) {
-  table_ = new AliasTableLink *[size_];
-  assert(table_);
-  memset(table_, 0, size_ * sizeof *table_);
-};
+    : impl_(new AliasTableImpl(size)) {
+}
 
 AliasTable::~AliasTable() {
-    for (int i = 0; i < size_; ++i) {
-        AliasTableLink* p = table_[i];
-        while (p) {
-            AliasTableLink *q = p;
-            p = p->d_next_p;
-            delete q;
-        }
-    }
-    delete[] table_;
+  delete impl_;
+}
+
+void AliasTable::Reserve(int num_aliases) {
+  impl_->d_aliases.Reserve(num_aliases);
+  impl_->reserve(num_aliases);
 }
 
 int AliasTable::Add(const char* alias, const char* original_name)  {
-    enum { FOUND_DIFFERENT = -1, NOT_FOUND = 0, FOUND_IDENTICAL = 1 };
+    return Add(alias, strlen(alias), original_name, strlen(original_name));
+}
 
-    AliasTableLink *&slot = table_[hash(alias) % size_];
-    AliasTableLink *p = slot;
+int AliasTable::Add(const char* alias, int alias_length,
+                    const char* original_name, int original_name_length) {
+    const char* previous_name;
+    return Add(alias, alias_length, original_name, original_name_length,
+               &previous_name);
+}
 
-    while (p && 0 != strcmp(p->d_alias_p, alias)) {
-        p = p->d_next_p;
+int AliasTable::Add(const char* alias, int alias_length,
+                    const char* original_name, int original_name_length,
+                    const char** previous_name) {
+    if (isPattern(alias, alias_length)) {
+        return impl_->addRule(alias, alias_length,
+                              original_name, original_name_length,
+                              previous_name);
     }
-    if (!p) {
-        slot = new AliasTableLink(alias, original_name, slot);
+
+    const int numAliases = impl_->d_aliases.Length();
+    const int index = impl_->d_aliases.Entry(alias, alias_length);
+    if (impl_->d_aliases.Length() > numAliases) {
+        impl_->reserve(index + 1);
+        impl_->d_targets_p[index] =
+            impl_->d_originals.Entry(original_name, original_name_length);
+        *previous_name = 0;
         return NOT_FOUND;
-    } else if (0 == strcmp(p->d_originalName_p, original_name)) {
-        return FOUND_IDENTICAL;
-    } else {
-        return FOUND_DIFFERENT;
     }
+
+    const int target = impl_->d_targets_p[index];
+    *previous_name = impl_->d_originals[target];
+    return target == impl_->d_originals.GetIndexByName(original_name,
+                                                       original_name_length)
+           ? FOUND_IDENTICAL
+           : FOUND_DIFFERENT;
 }
 
 const char* AliasTable::Lookup(const char* alias) const {
-    AliasTableLink* p = table_[hash(alias) % size_];
-    while (p && 0 != strcmp(p->d_alias_p, alias)) {
-        p = p->d_next_p;
+    return Lookup(alias, strlen(alias));
+}
+
+const char* AliasTable::Lookup(const char* alias, int length) const {
+    const int index = impl_->d_aliases.GetIndexByName(alias, length);
+    if (index >= 0) {
+        return impl_->d_originals[impl_->d_targets_p[index]];
     }
-    return p ? p->d_originalName_p : 0;
+    if (0 == impl_->d_patterns.Length()) {
+        return 0;
+    }
+    const int name = impl_->resolve(alias, length);
+    return NO_NAME != name ? impl_->d_originals[name] : 0;
+}
+
+int AliasTable::Length() const {
+    return impl_->d_aliases.Length() + impl_->d_patterns.Length();
 }
 
 std::ostream& operator<<(std::ostream &o, const AliasTable& table) {
@@ -125,33 +637,30 @@ AliasTableIterator::~AliasTableIterator() {
 }
 
 void AliasTableIterator::Reset() {
-  d_link_p = 0;
-  d_index = -1;
-  ++*this;
+  d_index = 0;
 }
 
 void AliasTableIterator::operator++() {
-    if (d_link_p) {
-        d_link_p = d_link_p->d_next_p;
-    }
-    while (!d_link_p && *this) {
-        ++d_index;
-        if (*this) {
-            d_link_p = table_.table_[d_index];
-        }
-    }
+  ++d_index;
 }
 
 AliasTableIterator::operator const void *() const {
-    return d_index < table_.size_ ? this : 0;
+    return d_index < table_.Length() ? this : 0;
 }
 
 const char* AliasTableIterator::GetAlias() const {
-    return d_link_p->d_alias_p;
+    const AliasTableImpl& impl = *table_.impl_;
+    const int numAliases = impl.d_aliases.Length();
+    return d_index < numAliases ? impl.d_aliases[d_index]
+                                : impl.d_patterns[d_index - numAliases];
 }
 
 const char* AliasTableIterator::GetOriginalName() const {
-    return d_link_p->d_originalName_p;
+    const AliasTableImpl& impl = *table_.impl_;
+    const int numAliases = impl.d_aliases.Length();
+    return impl.d_originals[d_index < numAliases
+                            ? impl.d_targets_p[d_index]
+                            : impl.d_ruleTargets_p[d_index - numAliases]];
 }
 
 }  // namespace idep
@@ -7,16 +7,36 @@
 
 namespace idep {
 
-class AliasTableLink;
-
-// This leaf component defines 2 classes:
-// Supports efficient (hashed) name to name mapping.
+class AliasTableImpl;
+
+// This component defines 2 classes:
+// Supports efficient (hashed) name to name mapping.  Aliases and original
+// names are each stored once, in growable hash tables, so a table of any
+// size keeps constant-time lookups and many aliases of one original name
+// share a single copy of it.
+//
+// An alias containing a '*' (any sequence of characters), a '?' (any one
+// character) or a bracketed character class such as "[a-z]" or "[!0-9]"
+// is a pattern that maps every name it matches in full to its original
+// name.  Each '*' in the original name of a pattern is replaced by the
+// text matched by the corresponding '*' of the pattern, each taking as
+// little as possible from left to right; e.g., "*_impl" -> "*" maps
+// "foo_impl" to "foo".  Plain aliases take precedence over patterns, and
+// among patterns the one added first wins.  All patterns are matched
+// together by one automaton, in a single pass over each name, and the
+// result is remembered (for a bounded number of names) so that looking
+// up the same name again costs a single hash probe.  Because of this, a
+// table is not thread-safe, even through its const methods.
 class AliasTable {
  public:
   // Create a new table; optionally specify expected number of entries.
   explicit AliasTable(int size_hint = 0);
   ~AliasTable();
 
+  // Make room for at least the specified number of aliases in all, so
+  // that adding that many does not need to grow the table.
+  void Reserve(int num_aliases);
+
   // Add an alias to the table.  Returns 0 on success, 1 if the
   // identical alias/originalName was already present, -1 if an
   // alias with a different original name was present.  Under
@@ -24,17 +44,37 @@ class AliasTable {
   // original name.  (Neither alias nor originalName may be 0.)
   int Add(const char* alias, const char* original_name);
 
-  // Return the original name if the alias exists, else 0.
+  // Same as Add(alias, original_name) for an alias and an original name
+  // of the specified lengths, neither of which need be null-terminated at
+  // that point.
+  int Add(const char* alias, int alias_length,
+          const char* original_name, int original_name_length);
+
+  // Same as Add(alias, alias_length, original_name, original_name_length),
+  // and if the alias was already present, also load the original name it
+  // maps to into |previous_name|, so that a conflict can be reported
+  // without a second lookup.
+  int Add(const char* alias, int alias_length,
+          const char* original_name, int original_name_length,
+          const char** previous_name);
+
+  // Return the original name if the alias exists or a pattern matches
+  // it, else 0.  Note that this function records its result for later
+  // calls (in a memo of bounded size), so it is not thread-safe: it must
+  // not be called by several threads at once, even on a const table.
   const char* Lookup(const char* alias) const;
 
+  // Same as Lookup(alias) for the first |length| characters of the
+  // specified alias, which need not be null-terminated at that point.
+  const char* Lookup(const char* alias, int length) const;
+
+  // Return the number of aliases, including patterns, in this table.
+  int Length() const;
+
  private:
   friend class AliasTableIterator;
 
-  // Hash Table.
-  AliasTableLink** table_;
-
-  // Size of hash table.
-  int size_;
+  AliasTableImpl* impl_;
 
   DISALLOW_COPY_AND_ASSIGN(AliasTable);
 };
@@ -43,7 +83,8 @@ class AliasTable {
 // reasonable format to the specified output stream.
 std::ostream& operator<<(std::ostream& output, const AliasTable& table);
 
-// Iterate through the collection of name mappings.
+// Iterate through the collection of name mappings: the plain aliases in
+// the order in which they were added, then the patterns likewise.
 class AliasTableIterator {
  public:
   // Create an iterator for the specified table.
@@ -69,10 +110,7 @@ class AliasTableIterator {
   // Reference to const alias table.
   const AliasTable& table_;
 
-  // Pointer to current link in table.
-  AliasTableLink* d_link_p;
-
-  // Index of current slot.
+  // Index of current alias.
   int d_index;
 
   DISALLOW_COPY_AND_ASSIGN(AliasTableIterator);
@@ -1,6 +1,7 @@
 #include "idep_alias_util.h"
 
 #include <assert.h>
+#include <string.h>  // strlen()
 
 #include <fstream>   // ifstream
 #include <iostream>
@@ -18,6 +19,10 @@ const char kCommentChar= '#';
 const char kContinueChar= '\\';
 const char kNewLineChar= '\n';
 
+// A rough lower bound on the number of bytes an alias takes up in a file
+// (a short name and a separator), used to size the table before reading.
+const int kBytesPerAlias = 16;
+
 std::ostream& warning(std::ostream& orf,
                       const char* file,
                       int line_number) {
@@ -34,8 +39,10 @@ int TryToAlias(AliasTable* table,
                int line_number,
                const char* component_name,
                const char* alias) {
-  if (table->Add(alias, component_name) < 0) {
-    const char* previous_name = table->Lookup(alias);
+  const char* previous_name;
+  if (table->Add(alias, strlen(alias),
+                 component_name, strlen(component_name),
+                 &previous_name) < 0) {
     err(orf, input_name, line_number) << "two names for alias \""
         << alias << "\":" << std::endl << "    \"" << previous_name
         << "\" and \"" << component_name << "\"" << std::endl;
@@ -207,6 +214,14 @@ int AliasUtil::ReadAliases(AliasTable* table,
   if (!in)
     return IOERROR;
 
+  // Size the table for the whole file up front rather than growing it
+  // repeatedly while reading.
+  in.seekg(0, std::ios::end);
+  const std::streamoff size = in.tellg();
+  in.seekg(0, std::ios::beg);
+  if (size > 0)
+    table->Reserve(table->Length() + static_cast<int>(size / kBytesPerAlias));
+
   return ReadAliases(table, orf, in, file_name);
 }
 
@@ -53,6 +53,15 @@ class AliasUtil {
   //   y\                         # y\ -> x
   //   z z \#oops                 # z -> z; \#oops -> z
   //
+  // A "from" name containing a '*', a '?' or a bracketed character class
+  // is a pattern (see AliasTable) that aliases every name it matches.
+  // A '*' in the "to" name of a pattern stands for the text matched by
+  // the corresponding '*' of the pattern.
+  //
+  //   foo src/foo/*_impl         # src/foo/bar_impl -> foo
+  //   * *_impl *_i               # bar_impl -> bar; baz_i -> baz
+  //   lib*_test *_t[0-9]         # x_t1 -> libx_test
+  //
   // The read-from-file function returns -1 if the file is not readable.
   // Otherwise both functions return the non-negative number of aliases
   // that where inconsistent with existing alias definitions.  All such
@@ -5,82 +5,257 @@
 
 #include <iostream>
 
+#include "idep_row_kernel.h"
+#include "idep_strong_components.h"
+
 // IMPLEMENTATION NOTE: MEMORY LAYOUT
 // +---------+          +---------+             +---+---+---+---+
 // |         |--------->|         |------------>|   |   |   |   |
 // +---------+          +---------+             +---+---+---+---+
-//    char**            |         |------------>|   |   |   |   |
+//    Word**            |         |------------>|   |   |   |   |
 //                      +---------+             +---+---+---+---+
 //                      |         |------------>|   |   |   |   |
 //                      +---------+             +---+---+---+---+
 //                      |         |------------>|   |   |   |   |
 //                      +---------+             +---+---+---+---+
-//                      char*[size]             contiguous memory
-//                                              char[size * size]
+//                      Word*[size]             contiguous memory
+//                                              Word[size * words]
+//
+// Each row holds |words| 64-bit words (at least enough for |size| bits),
+// so the relation occupies roughly size * size / 8 bytes.  Bits at columns
+// at or beyond the logical length are always 0; the bitwise row operations
+// below rely on this.  They touch only the first |length| rows and the
+// words covering |length| columns, so the relation need never be shrunk
+// to its logical size first.
+//
+// Copies share the word array (and the array of row pointers) along with
+// a count of the relations sharing it.  A relation that is about to be
+// modified while the count exceeds 1 first makes a private copy (see
+// unshare), so a copy that is only read costs no more than a pointer.
+// The count is updated atomically, since relations sharing storage may
+// be used by different threads; whichever relation drops the count to 0
+// frees the storage.
 
 enum { START_SIZE = 1, GROW_FACTOR = 2 };
 
-static void clean(char** p)  {
-  /* crash, bt:
-#0  0x00002aaaab08011d in raise () from /lib/libc.so.6
-#1  0x00002aaaab08184e in abort () from /lib/libc.so.6
-#2  0x00002aaaab0b4e41 in __fsetlocking () from /lib/libc.so.6
-#3  0x00002aaaab0ba90e in malloc_usable_size () from /lib/libc.so.6
-#4  0x00002aaaab0bac56 in free () from /lib/libc.so.6
-#5  0x000000000040a0ab in clean (p=0x526a50) at idep_binary_relation.cc:28
-#6  0x000000000040a46f in ~BinaryRelation (this=0x527b60) at idep_binary_relation.cc:124
-#7  0x000000000040254b in ~idep_LinkDep_i (this=0x523460) at idep_ldep.cxx:150
-#8  0x00000000004042dc in ~idep_LinkDep (this=0x7fffffb944a0) at idep_ldep.cxx:700
-#9  0x0000000000401dbf in main (argc=5, argv=0x7fffffb94608) at ldep.cxx:199
-*/
+// Parameters of the blocked closure: pivots are processed 256 rows at a
+// time, and the other rows are updated in tiles of 128 words (8192
+// columns), so that the pivot tile being reused (256 KB) stays in L2.
+enum { PIVOT_BLOCK_ROWS = 256, COLUMN_TILE_WORDS = 128 };
+
+typedef idep::BinaryRelation::Word Word;
+
+static void clean(Word** p)  {
     delete [] *p;               // only one 2-d block is allocated
     delete [] p;                // delete single block
 }
 
-static char** alloc(int size) {
+static Word** alloc(int size, int words) {
     register int s = size;
-    char **rel = new char *[s];
-    register char *p = new char[s * s];
-    for (register int i = 0; i < s; ++i, p += s) {
+    Word **rel = new Word *[s];
+    register Word *p = new Word[size_t(s) * words];
+    for (register int i = 0; i < s; ++i, p += words) {
         rel[i] = p;
     }
     return rel;
 }
 
-static void clear(char *const *rel, int size) {
-    memset(*rel, 0, size * size);
+static void clear(Word *const *rel, int size, int words) {
+    memset(*rel, 0, size_t(size) * words * sizeof **rel);
 }
 
-static void copy(char **left, const char *const *right, int size) {
-    memcpy(*left, *right, size * size);
+static void copy(Word **left, const Word *const *right, int size, int words) {
+    memcpy(*left, *right, size_t(size) * words * sizeof **left);
+}
+
+static int nextBit(const Word *row, int words, int col) {
+    // Return the first column at or after col whose bit is set in the
+    // specified row, or -1 if there is none.
+    enum { BITS = idep::BinaryRelation::BITS_PER_WORD };
+    int i = col / BITS;
+    if (i >= words) {
+        return -1;
+    }
+    Word bits = row[i] & (~Word(0) << (col % BITS));
+    while (!bits) {
+        if (++i >= words) {
+            return -1;
+        }
+        bits = row[i];
+    }
+    return i * BITS + __builtin_ctzll(bits);
+}
+
+struct BitSuccessors {
+    // Enumerate the 1's of a row for idep::StrongComponents.
+    Word *const *rel;
+    int words;
+
+    int operator()(int row, int *cursor) const {
+        const int col = nextBit(rel[row], words, *cursor);
+        if (col >= 0) {
+            *cursor = col + 1;
+        }
+        return col;
+    }
+};
+
+static void closeRows(Word *const *rel, int words, int kBegin, int kEnd,
+                      int rBegin, int rEnd, int bit) {
+    // Apply Warshall's algorithm with the pivots in [kBegin, kEnd) to the
+    // rows in [rBegin, rEnd).  With one bit per column, the innermost loop
+    // over columns becomes a word-parallel operation on the whole row (see
+    // idep_row_kernel): row_r |= row_k when setting, and row_r &= ~row_k
+    // when clearing.  The bit for column k itself must not be written
+    // (self dependency is ignored).  That bit is known to be 1 in row_r,
+    // so setting leaves it alone, and clearing simply restores it
+    // afterwards.
+
+    enum { BITS = idep::BinaryRelation::BITS_PER_WORD };
+    for (int k = kBegin; k < kEnd; ++k) {
+        register const Word *row_k = rel[k];
+        const int kWord = k / BITS;
+        const Word kBit = Word(1) << (k % BITS);
+        for (register int r = rBegin; r < rEnd; ++r) {
+            register Word *row_r = rel[r];
+            if (!(row_r[kWord] & kBit)) {
+                continue;                   // huge optimization
+            }
+            if (r == k) {
+                continue;                   // note: ignore self dependency
+            }
+            if (bit) {
+                idep::RowKernel::Or(row_r, row_k, words);
+            }
+            else {
+                idep::RowKernel::AndNot(row_r, row_k, words);
+                row_r[kWord] |= kBit;       // note: ignore self dependency
+            }
+        }
+    }
+}
+
+static void blockRows(Word *const *rel, int s, int w, Word *pivots) {
+    // Perform the blocked closure (see BinaryRelation::blockedClosure) of
+    // the |s| rows, using the specified scratch array, which must have
+    // room for PIVOT_BLOCK_ROWS bits per row.
+
+    enum { BITS = idep::BinaryRelation::BITS_PER_WORD };
+    const int pivotWords = PIVOT_BLOCK_ROWS / BITS;
+
+    for (int kb = 0; kb < s; kb += PIVOT_BLOCK_ROWS) {
+        const int ke = s - kb > PIVOT_BLOCK_ROWS ? kb + PIVOT_BLOCK_ROWS : s;
+        const int pw0 = kb / BITS;                      // first word of P
+        const int pn = (ke + BITS - 1) / BITS - pw0;    // words of P
+
+        // Step 1: close the pivot rows (self dependency is ignored).
+        closeRows(rel, w, kb, ke, kb, ke, 1);
+
+        // Step 2: record S for each other row, then update tile by tile.
+        // Rows of P get an empty S as they are already complete.
+        for (int i = 0; i < s; ++i) {
+            Word *p = pivots + i * pivotWords;
+            if (i >= kb && i < ke) {
+                memset(p, 0, pn * sizeof *p);
+            }
+            else {
+                memcpy(p, rel[i] + pw0, pn * sizeof *p);
+            }
+        }
+
+        for (int t0 = 0; t0 < w; t0 += COLUMN_TILE_WORDS) {
+            const int tn = w - t0 > COLUMN_TILE_WORDS ? COLUMN_TILE_WORDS
+                                                      : w - t0;
+            for (int i = 0; i < s; ++i) {
+                const Word *p = pivots + i * pivotWords;
+                Word *row = rel[i] + t0;
+                for (int j = 0; j < pn; ++j) {
+                    for (Word bits = p[j]; bits; bits &= bits - 1) {
+                        int k = (pw0 + j) * BITS + __builtin_ctzll(bits);
+                        idep::RowKernel::Or(row, rel[k] + t0, tn);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void uniteComponent(Word *const *rel, int w, const int *components,
+                           const int *members, const int *start, int c,
+                           Word *reach) {
+    // Load the closure of component c into the rows of its members (see
+    // BinaryRelation::condensationClosure), using the specified scratch
+    // row; the components c reaches must already be closed.
+
+    enum { BITS = idep::BinaryRelation::BITS_PER_WORD };
+    memset(reach, 0, w * sizeof *reach);
+    for (int m = start[c]; m < start[c + 1]; ++m) {
+        const Word *row = rel[members[m]];
+        for (int u = nextBit(row, w, 0); u >= 0; u = nextBit(row, w, u + 1)) {
+            const int uWord = u / BITS;
+            const Word uBit = Word(1) << (u % BITS);
+            if (components[u] != c && !(reach[uWord] & uBit)) {
+                idep::RowKernel::Or(reach, rel[u], w);
+            }
+            reach[uWord] |= uBit;
+        }
+    }
+    for (int m = start[c]; m < start[c + 1]; ++m) {
+        memcpy(rel[members[m]], reach, w * sizeof *reach);
+    }
 }
 
 namespace idep {
 
 void BinaryRelation::grow() {
-    int newSize = d_size * GROW_FACTOR;
-    char **tmp = d_rel_p;
-    d_rel_p = alloc(newSize);
-    clear(d_rel_p, newSize);
+    reserve(d_size > 0 ? d_size * GROW_FACTOR : START_SIZE);
+}
+
+void BinaryRelation::reserve(int entries) {
+    if (entries <= d_size) {
+        return;
+    }
+
+    // The row capacity is simply raised to |entries|; the number of words
+    // per row is doubled as often as needed to hold that many columns, so
+    // most increases in row capacity need no wider rows.
+
+    int newWords = d_words > 0 ? d_words : 1;
+    while (newWords < WordsFor(entries)) {
+        newWords *= GROW_FACTOR;
+    }
+
+    Word **rel = alloc(entries, newWords);
+    clear(rel, entries, newWords);
 
-    for (int i = 0; i < d_size; ++i)
-        memcpy(d_rel_p[i], tmp[i], d_size);
+    // Only the words covering the logical length hold any 1's.
+    const int used = WordsFor(d_length);
+    for (int i = 0; i < d_length; ++i)
+        memcpy(rel[i], d_rel_p[i], used * sizeof **rel);
 
-    d_size = newSize;
-    clean(tmp);
+    release();
+    d_rel_p = rel;
+    d_count_p = new int(1);
+    d_size = entries;
+    d_words = newWords;
 }
 
-void BinaryRelation::compress() {
-    if (d_size > d_length && d_length > 0) {
-        d_size = d_length;
-        char **tmp = d_rel_p;
-        d_rel_p = alloc(d_size);
-        clear(d_rel_p, d_size);
-        for (int i = 0; i < d_size; ++i) {
-            memcpy(d_rel_p[i], tmp[i], d_size);
-        }
-        clean(tmp);
+void BinaryRelation::detach() {
+    Word **rel = alloc(d_size, d_words);
+    copy(rel, d_rel_p, d_size, d_words);
+    release();              // the other sharers may have let go meanwhile
+    d_rel_p = rel;
+    d_count_p = new int(1);
+}
+
+void BinaryRelation::release() {
+    if (d_count_p &&
+                0 == __atomic_sub_fetch(d_count_p, 1, __ATOMIC_ACQ_REL)) {
+        clean(d_rel_p);
+        delete d_count_p;
     }
+    d_rel_p = 0;
+    d_count_p = 0;
 }
 
 BinaryRelation::BinaryRelation(int initial_entries, int max_entries_hint)
@@ -89,35 +264,74 @@ BinaryRelation::BinaryRelation(int initial_entries, int max_entries_hint)
     if (d_size < d_length)
         d_size = d_length;
 
-    d_rel_p = alloc(d_size);
-    clear(d_rel_p, d_size);
+    d_words = WordsFor(d_size);
+    d_rel_p = alloc(d_size, d_words);
+    d_count_p = new int(1);
+    clear(d_rel_p, d_size, d_words);
 }
 
 BinaryRelation::BinaryRelation(const BinaryRelation& rel)
-    : d_size(rel.d_size),
-      d_length(rel.d_length),
-      d_rel_p(alloc(rel.d_size)) {
-  // TODO
-  copy(d_rel_p, d_rel_p + d_size, rel.d_size);
+    : d_rel_p(rel.d_rel_p),
+      d_count_p(rel.d_count_p),
+      d_size(rel.d_size),
+      d_words(rel.d_words),
+      d_length(rel.d_length) {
+    if (d_count_p) {
+        __atomic_add_fetch(d_count_p, 1, __ATOMIC_RELAXED);
+    }
 }
 
 BinaryRelation& BinaryRelation::operator=(const BinaryRelation& rel) {
-    if (&rel != this) {
-        if (d_size != rel.d_size) {
-            clean(d_rel_p);
-            d_size = rel.d_size;
-            d_rel_p = alloc(d_size);
+    if (rel.d_count_p != d_count_p || !d_count_p) {
+        if (rel.d_count_p) {
+            // first, in case rel shares our storage
+            __atomic_add_fetch(rel.d_count_p, 1, __ATOMIC_RELAXED);
         }
-        //TODO: There is a BUG HERE!
-	copy(d_rel_p, d_rel_p + d_size, rel.d_size);
-	//	copy(d_rel_p, rel.d_rel_p, d_size);
+        release();
+        d_rel_p = rel.d_rel_p;
+        d_count_p = rel.d_count_p;
+        d_size = rel.d_size;
+        d_words = rel.d_words;
+    }
+    d_length = rel.d_length;
+    return *this;
+}
+
+#if __cplusplus >= 201103L
+BinaryRelation::BinaryRelation(BinaryRelation&& rel) noexcept
+    : d_rel_p(rel.d_rel_p),
+      d_count_p(rel.d_count_p),
+      d_size(rel.d_size),
+      d_words(rel.d_words),
+      d_length(rel.d_length) {
+    rel.d_rel_p = 0;
+    rel.d_count_p = 0;
+    rel.d_size = rel.d_words = rel.d_length = 0;
+}
+
+BinaryRelation& BinaryRelation::operator=(BinaryRelation&& rel) noexcept {
+    if (&rel != this) {
+        release();
+        d_rel_p = rel.d_rel_p;
+        d_count_p = rel.d_count_p;
+        d_size = rel.d_size;
+        d_words = rel.d_words;
         d_length = rel.d_length;
+        rel.d_rel_p = 0;
+        rel.d_count_p = 0;
+        rel.d_size = rel.d_words = rel.d_length = 0;
     }
     return *this;
 }
+#endif
 
 BinaryRelation::~BinaryRelation() {
-  clean(d_rel_p); // part of crash
+    release();
+}
+
+int BinaryRelation::strongComponents(int *components) const {
+    const BitSuccessors next = { d_rel_p, WordsFor(d_length) };
+    return StrongComponents(d_length, next, components);
 }
 
 int BinaryRelation::cmp(const BinaryRelation& rel) const {
@@ -126,13 +340,11 @@ int BinaryRelation::cmp(const BinaryRelation& rel) const {
     if (d_length != rel.d_length)
         return DIFFERENT;
 
-    if (d_size == rel.d_size &&
-        memcmp(*d_rel_p, *rel.d_rel_p, d_size * d_size)) {
-        return DIFFERENT;
-    }
-
+    // Bits beyond the logical length are always 0, so comparing the
+    // words that cover the logical length is sufficient.
+    int words = WordsFor(d_length);
     for (int i = 0; i < d_length; ++i) {
-        if (memcmp(d_rel_p[i], rel.d_rel_p[i], d_length))
+        if (memcmp(d_rel_p[i], rel.d_rel_p[i], words * sizeof **d_rel_p))
             return DIFFERENT;
     }
 
@@ -157,43 +369,133 @@ void BinaryRelation::warshall(int bit) {
     // Addison-Wesley, Reading MA, pp. 212-213.  Also see, Warshall, S. [1962].
     // "A theorem on Boolean matrices," Journal of the ACM, 9:1, pp. 11-12.
 
-    compress();
-    assert(d_size == d_length || 0 == d_length);
+    const int s = d_length;
+    closeRows(d_rel_p, WordsFor(s), 0, s, 0, s, bit);
+}
 
-    register const int VALUE = !!bit;
-    register int s = d_length;  // size and length are the same or length is 0
-    register char *top_row = d_rel_p[0] + s * s;
+void BinaryRelation::blockedClosure() {
+    // This is Warshall's algorithm with the pivots taken PIVOT_BLOCK_ROWS
+    // at a time.  For each block P of pivots:
+    //
+    //   1. The rows of P are closed among themselves exactly as warshall()
+    //      would do it.  Each pivot row then holds every path whose
+    //      intermediate components lie in P or in an earlier block.
+    //
+    //   2. For each other row i, let S be the pivots k in P for which
+    //      A[i][k] was set before step 2.  A path from i via P must enter
+    //      P at one of those pivots, so ORing the pivot rows of S into
+    //      row i completes it.  This is done one column tile at a time,
+    //      so each tile of the pivot rows is reused for every other row
+    //      while it is still in cache.
+    //
+    // The matrix is thus streamed through memory once per block rather
+    // than once per pivot.  Since the transitive closure is unique, the
+    // result is identical to that of warshall(1).
+
+    const int s = d_length;
+    Word *pivots = new Word[s * (PIVOT_BLOCK_ROWS / BITS_PER_WORD)];
+    blockRows(d_rel_p, s, WordsFor(s), pivots);
+    delete [] pivots;
+}
 
-    for (int k = 0; k < s; ++k) {
-        register char *row_k = d_rel_p[k];
-        for (register char *row_r = d_rel_p[0]; row_r < top_row; row_r += s) {
-            if (!row_r[k]) {
-                continue;                   // huge optimization
-            }
-            if (d_rel_p[k] == row_r) {
-                continue;                   // note: ignore self dependency
-            }
-            for (register int c = 0; c < s; ++c) {
-                if (row_k[c] && row_r[k]) { // note: both conditions are needed
-                                            // in reverse (consider k == c).
-                    if (c != k) {           // note: ignore self dependency
-                        row_r[c] = VALUE;
-                    }
-                }
-            }
-        }
+void BinaryRelation::condensationClosure() {
+    // The closure of an entry is the union of its own row with the
+    // closures of its direct successors, and every member of a strong
+    // component has the same closure.  Visiting the components in reverse
+    // topological order, the closure of every successor outside the
+    // current component is therefore already final, so each component
+    // needs one row union per outgoing edge -- or less: a successor whose
+    // bit was already contributed by an earlier union is reachable, and
+    // so is everything in its closure.  For a sparse dependency graph this
+    // costs about O(V * E / 64) rather than the O(V^3 / 64) of Warshall.
+
+    const int s = d_length;
+    const int w = WordsFor(s);
+
+    int *components = new int[s];
+    const int n = strongComponents(components);
+
+    // Group the members of each component together (counting sort).
+    int *start = new int[n + 1];
+    int *members = new int[s];
+    memset(start, 0, (n + 1) * sizeof *start);
+    for (int i = 0; i < s; ++i) {
+        ++start[components[i] + 1];
+    }
+    for (int c = 0; c < n; ++c) {
+        start[c + 1] += start[c];
+    }
+    for (int i = 0; i < s; ++i) {
+        members[start[components[i]]++] = i;
+    }
+    for (int c = n; c > 0; --c) {
+        start[c] = start[c - 1];
+    }
+    start[0] = 0;
+
+    Word *reach = new Word[w > 0 ? w : 1];
+    for (int c = 0; c < n; ++c) {
+        uniteComponent(d_rel_p, w, components, members, start, c, reach);
+    }
+
+    delete [] reach;
+    delete [] members;
+    delete [] start;
+    delete [] components;
+}
+
+void BinaryRelation::makeTransitive(Algorithm algorithm) {
+    unshare();
+    switch (algorithm) {
+      case BLOCKED: {
+        blockedClosure();
+      } break;
+      case WARSHALL: {
+        warshall(1);
+      } break;
+      default:
+      case DEFAULT:
+      case CONDENSATION: {
+        condensationClosure();
+      } break;
     }
 }
 
-void BinaryRelation::makeTransitive() {
-  warshall(1);
+void BinaryRelation::insertEdgeClosed(int row, int col) {
+    // A path that uses the new edge more than once can be shortened to
+    // use it once, so the new paths are exactly those that reach row (or
+    // start there), take the edge, and continue along a path from col.
+
+    if (get(row, col)) {
+        return;                         // already implied; nothing changes
+    }
+    unshare();
+
+    const int w = WordsFor(d_length);
+    const int rowWord = row / BITS_PER_WORD;
+    const Word rowBit = Word(1) << (row % BITS_PER_WORD);
+
+    // The row of col is itself updated if col reaches row, so unite the
+    // other rows with a copy of it.
+    Word *reach = new Word[w > 0 ? w : 1];
+    memcpy(reach, d_rel_p[col], w * sizeof *reach);
+    reach[col / BITS_PER_WORD] |= Word(1) << (col % BITS_PER_WORD);
+
+    for (int i = 0; i < d_length; ++i) {
+        if (i == row || (d_rel_p[i][rowWord] & rowBit)) {
+            RowKernel::Or(d_rel_p[i], reach, w);
+        }
+    }
+
+    delete [] reach;
 }
 
 void BinaryRelation::makeNonTransitive() {
+  unshare();
   warshall(0);
   // make non-reflexive too -- i.e., subtract the identity matrix.
   for (int i = 0; i < Length(); ++i)
-    d_rel_p[i][i] = 0;
+    clr(i, i);
 }
 
 std::ostream& operator<<(std::ostream& o, const BinaryRelation& rel) {
@@ -1,6 +1,8 @@
 #ifndef IDEP_BINARY_RELATION_H_
 #define IDEP_BINARY_RELATION_H_
 
+#include <stdint.h>
+
 #include <ostream>
 
 namespace idep {
@@ -9,6 +11,20 @@ namespace idep {
 // Square matrix of bits with transitive closure capability.
 class BinaryRelation {
  public:
+  // Each row of the relation is packed into an array of 64-bit words;
+  // column c of a row lives in bit (c % BITS_PER_WORD) of word
+  // (c / BITS_PER_WORD).
+  typedef uint64_t Word;
+  enum { BITS_PER_WORD = 64 };
+
+  // Algorithms available to compute the transitive closure.
+  enum Algorithm {
+    DEFAULT,      // generally the fastest (currently CONDENSATION)
+    WARSHALL,     // classic Warshall's algorithm, one pivot at a time
+    BLOCKED,      // Warshall's algorithm over cache-sized tiles
+    CONDENSATION  // unite rows over the DAG of strong components
+  };
+
   // Create a binary relation that can be extended as needed.
   // By default, the initial number of entires in the relation
   // is 0.  If the final number of entries is known and is not
@@ -16,11 +32,24 @@ class BinaryRelation {
   // specified as the second argument (as a "hint").
   BinaryRelation(int initial_entries = 0, int max_entries_hint = 0);
 
+  // Create a copy of the specified relation.  The copy shares storage
+  // with the original until either of them is modified, so copying is
+  // cheap and a copy that is only read never duplicates the matrix.  The
+  // sharing is thread-safe: the copy and the original may be used (and
+  // modified) by different threads, as may the copies of a copy, though
+  // any one relation must still not be modified by one thread while
+  // another uses it.
   BinaryRelation(const BinaryRelation& rel);
   ~BinaryRelation();
 
   BinaryRelation& operator=(const BinaryRelation& rel);
 
+#if __cplusplus >= 201103L
+  // Take over the storage of the specified relation, leaving it empty.
+  BinaryRelation(BinaryRelation&& rel) noexcept;
+  BinaryRelation& operator=(BinaryRelation&& rel) noexcept;
+#endif
+
   // Set the specified row/col of this relation to the specified 
   // binary value.
   void set(int row, int col, int bit);
@@ -31,9 +60,19 @@ class BinaryRelation {
   void clr(int row, int col);
   // Set specified row/col of this relation to 0.
 
-  void makeTransitive();
+  void makeTransitive(Algorithm algorithm = DEFAULT);
   // Apply Warshall's algorithm to this relation.  The result is the
-  // reflexive transitive closure of the original relation.
+  // reflexive transitive closure of the original relation.  The optional
+  // argument selects the algorithm used; every algorithm yields the same
+  // relation.
+
+  void insertEdgeClosed(int row, int col);
+  // Set the specified row/col of this relation to 1 and restore the
+  // transitive closure: every row that has a 1 in column row, and row
+  // itself, is united with the row of col and gets a 1 in column col.
+  // The relation must already be transitive (see makeTransitive); the
+  // result is then the same as setting row/col and calling makeTransitive
+  // again, at a cost of O(Length() * Length() / 64) rather than cubic.
 
   void makeNonTransitive();
   // Remove all redundant relationships such that the transitive
@@ -46,6 +85,10 @@ class BinaryRelation {
   // Append an entry to this relation and return its integer index.
   // The logical size is increased by 1 with all new entries 0'ed.
 
+  void reserve(int entries);
+  // Make room for at least the specified number of entries, so that the
+  // relation can be extended to that length without reallocation.
+
   // ACCESSORS
   int get(int row, int col) const;
   // Get the boolean value at the specified row/col of this relation.
@@ -54,6 +97,16 @@ class BinaryRelation {
   // Return 0 if and only if the specified relation has the same
   // length and logical values as this relation.
 
+  int strongComponents(int *components) const;
+  // Partition the entries of this relation into strongly connected
+  // components (maximal sets of mutually reachable entries) and load the
+  // component index of each entry into the specified array, which must
+  // have room for Length() values.  Components are numbered in reverse
+  // topological order: an entry depends only on entries in the same or
+  // a lower-numbered component.  Return the number of components.
+  // This function runs in O(Length() * Length() / 64 + E) time, where E
+  // is the number of 1's in the relation.
+
   // Return number of rows and columns in this relation.  The length
   // represents the cardinality of the set on which this relation is
   // defined.
@@ -63,14 +116,34 @@ class BinaryRelation {
   // Increase the physical size of this relation.
   void grow();
 
-  // Make the physical size same as Logical size (unless that is 0).
-  void compress();
+  // Give this relation storage of its own if it shares that of a copy;
+  // must precede any modification of the bits of this relation.
+  void unshare();
+
+  // Replace the shared storage of this relation with a private copy.
+  void detach();
+
+  // Give up this relation's share of its storage.
+  void release();
 
   // Perform Warshall's algorithm either forward or backward. 
   void warshall(int bit);
 
-  char **d_rel_p;     // array of pointers into a contiguous byte array
-  int d_size;         // physical size of array
+  // Compute the transitive closure one block of pivots at a time, such
+  // that the rows and columns being updated stay in cache.
+  void blockedClosure();
+
+  // Compute the transitive closure by visiting the strong components in
+  // reverse topological order and uniting the closed rows they reach.
+  void condensationClosure();
+
+  // Return the number of words needed to hold |size| bits.
+  static int WordsFor(int size);
+
+  Word **d_rel_p;     // array of pointers into a contiguous word array
+  int *d_count_p;     // number of relations sharing d_rel_p
+  int d_size;         // physical size of array (capacity in rows)
+  int d_words;        // number of words in each row (capacity in columns)
   int d_length;       // logical size of array
 };
 
@@ -91,20 +164,37 @@ inline int BinaryRelation::appendEntry() {
     return d_length++;
 }
 
+inline int BinaryRelation::WordsFor(int size) {
+    return (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
 inline void BinaryRelation::set(int row, int col, int bit) {
-    d_rel_p[row][col] = !!bit;
+    if (bit) {
+        set(row, col);
+    }
+    else {
+        clr(row, col);
+    }
+}
+
+inline void BinaryRelation::unshare() {
+    if (d_count_p && __atomic_load_n(d_count_p, __ATOMIC_ACQUIRE) > 1) {
+        detach();
+    }
 }
 
 inline void BinaryRelation::set(int row, int col) {
-    d_rel_p[row][col] = 1;
+    unshare();
+    d_rel_p[row][col / BITS_PER_WORD] |= Word(1) << (col % BITS_PER_WORD);
 }
 
 inline void BinaryRelation::clr(int row, int col) {
-    d_rel_p[row][col] = 0;
+    unshare();
+    d_rel_p[row][col / BITS_PER_WORD] &= ~(Word(1) << (col % BITS_PER_WORD));
 }
 
 inline int BinaryRelation::get(int row, int col) const {
-    return d_rel_p[row][col];
+    return (d_rel_p[row][col / BITS_PER_WORD] >> (col % BITS_PER_WORD)) & 1;
 }
 
 inline int BinaryRelation::Length() const {
@@ -0,0 +1,329 @@
+// Check that every closure algorithm of BinaryRelation yields the same
+// relation as Warshall's algorithm, that insertEdgeClosed keeps a closed
+// relation closed, and that makeNonTransitive yields a reduction with the
+// same closure, on random relations whose sizes lie around the word (64
+// columns) and block (256 pivot rows and 8192 columns) boundaries.  Also
+// check that copies, assignments and moves behave as independent values.
+// Exit with the number of mismatches found.
+
+#include "idep_binary_relation.h"
+
+#include <stdio.h>
+
+#include <utility>
+
+namespace {
+
+using idep::BinaryRelation;
+
+// Return the next value of a small linear congruential generator, so
+// that the relations, and any mismatch reported, are the same everywhere.
+unsigned Random(unsigned *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+// Fill the specified relation, which must be empty if growFlag is set and
+// of the specified length otherwise, with about |edges| random 1's.
+void Fill(BinaryRelation *rel, int length, int edges, unsigned seed,
+          int growFlag) {
+    if (growFlag) {
+        for (int i = 0; i < length; ++i) {
+            rel->appendEntry();
+        }
+    }
+    unsigned state = seed;
+    for (int e = 0; length && e < edges; ++e) {
+        int row = Random(&state) % length;
+        int col = Random(&state) % length;
+        rel->set(row, col);
+    }
+}
+
+// Return 1 if the specified reduction of the specified closed relation
+// is correct, and 0 otherwise.  The reduction must have no diagonal 1's,
+// keep only 1's of the closure and have the same closure (apart from the
+// diagonal, which makeTransitive leaves as it finds it outside cycles).
+// If the relation is acyclic, its reduction is unique: an entry depends
+// directly on exactly those it reaches by no path through a third.
+int IsReduction(const BinaryRelation& reduced, const BinaryRelation& closed,
+                int acyclicFlag) {
+    const int length = closed.Length();
+    for (int i = 0; i < length; ++i) {
+        if (reduced.get(i, i)) {
+            return 0;
+        }
+        for (int j = 0; j < length; ++j) {
+            if (reduced.get(i, j) && !closed.get(i, j)) {
+                return 0;
+            }
+            if (!acyclicFlag || i == j || !closed.get(i, j)) {
+                continue;
+            }
+            int implied = 0;
+            for (int k = 0; k < length && !implied; ++k) {
+                implied = k != i && k != j && closed.get(i, k)
+                                           && closed.get(k, j);
+            }
+            if (reduced.get(i, j) == implied) {
+                return 0;
+            }
+        }
+    }
+    BinaryRelation reclosed(reduced);
+    reclosed.makeTransitive(BinaryRelation::WARSHALL);
+    for (int i = 0; i < length; ++i) {
+        for (int j = 0; j < length; ++j) {
+            if (i != j && reclosed.get(i, j) != closed.get(i, j)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Return the number of ways in which copies, assignments and (where
+// supported) moves of relations fail to behave as independent values,
+// reporting each of them.
+int CheckValueSemantics() {
+    enum { LENGTH = 100, EDGES = 200, SEED = 12345 };
+    int failures = 0;
+
+    BinaryRelation reference(LENGTH);
+    Fill(&reference, LENGTH, EDGES, SEED, 0);
+
+    // A copy shares storage until modified: modifying either the copy or
+    // the original (through copies of copies, too) must not affect the
+    // other.
+    BinaryRelation original(LENGTH);
+    Fill(&original, LENGTH, EDGES, SEED, 0);
+    BinaryRelation copy(original);
+    BinaryRelation copyOfCopy(copy);
+    BinaryRelation assigned;
+    assigned = copy;
+    copy.set(0, 1);
+    copy.clr(0, 1);
+    copy.set(1, 0);
+    original.appendEntry();
+    copyOfCopy.makeTransitive();
+    if (!copy.get(1, 0) || copy.get(0, 1) || copy.Length() != LENGTH) {
+        printf("FAIL: modifying a copy is not seen by the copy\n");
+        ++failures;
+    }
+    if (original.Length() != LENGTH + 1 || original.get(1, 0) !=
+                                                    reference.get(1, 0)) {
+        printf("FAIL: modifying a copy changes the original\n");
+        ++failures;
+    }
+    if (assigned != reference) {
+        printf("FAIL: modifying a relation changes an assigned copy\n");
+        ++failures;
+    }
+    BinaryRelation closed(reference);
+    closed.makeTransitive(BinaryRelation::WARSHALL);
+    if (copyOfCopy != closed) {
+        printf("FAIL: a closed copy of a copy is not the closure\n");
+        ++failures;
+    }
+
+    // Assigning a relation to itself, or a copy that shares its storage,
+    // must change nothing and leave it modifiable.
+    BinaryRelation self(reference);
+    const BinaryRelation& alias = self;
+    self = alias;
+    BinaryRelation shared(self);
+    self = shared;
+    shared.set(2, 3);
+    if (self != reference) {
+        printf("FAIL: self-assignment changes the relation\n");
+        ++failures;
+    }
+    self.set(3, 2);
+    if (!self.get(3, 2) || reference.get(3, 2) != shared.get(3, 2)) {
+        printf("FAIL: a self-assigned relation is not independent\n");
+        ++failures;
+    }
+
+#if __cplusplus >= 201103L
+    // A moved-from relation is left empty but usable.
+    BinaryRelation source(reference);
+    BinaryRelation moved(std::move(source));
+    if (moved != reference || source.Length() != 0) {
+        printf("FAIL: move construction does not take over the storage\n");
+        ++failures;
+    }
+    BinaryRelation target(LENGTH / 2);
+    target = std::move(moved);
+    BinaryRelation& movedAlias = target;
+    target = std::move(movedAlias);
+    if (target != reference || moved.Length() != 0) {
+        printf("FAIL: move assignment does not take over the storage\n");
+        ++failures;
+    }
+    source.appendEntry();
+    source.set(0, 0);
+    moved = source;
+    if (source.Length() != 1 || !source.get(0, 0) || moved != source) {
+        printf("FAIL: a moved-from relation cannot be reused\n");
+        ++failures;
+    }
+#endif
+
+    return failures;
+}
+
+const char *Name(BinaryRelation::Algorithm algorithm) {
+    switch (algorithm) {
+      case BinaryRelation::WARSHALL: return "WARSHALL";
+      case BinaryRelation::BLOCKED: return "BLOCKED";
+      case BinaryRelation::CONDENSATION: return "CONDENSATION";
+      default: return "DEFAULT";
+    }
+}
+
+}  // namespace
+
+int main() {
+    const int sizes[] = {
+        0, 1, 2, 63, 64, 65, 127, 128, 129, 255, 256, 257, 511, 512, 513,
+        1000, 8191, 8192, 8193
+    };
+    const int numSizes = sizeof sizes / sizeof *sizes;
+
+    // Edges per entry: below, around and above the threshold at which a
+    // random relation gains a giant strong component.
+    const double densities[] = { 0.5, 1.0, 2.0, 8.0 };
+    const int numDensities = sizeof densities / sizeof *densities;
+
+    const BinaryRelation::Algorithm algorithms[] = {
+        BinaryRelation::BLOCKED,
+        BinaryRelation::CONDENSATION,
+        BinaryRelation::DEFAULT
+    };
+    const int numAlgorithms = sizeof algorithms / sizeof *algorithms;
+
+    int failures = 0;
+    int cases = 0;
+    for (int s = 0; s < numSizes; ++s) {
+        for (int d = 0; d < numDensities; ++d) {
+            const int length = sizes[s];
+            if (length > 1000 && densities[d] > 1.0) {
+                continue;  // too slow for WARSHALL, and no new cases
+            }
+            const int edges = int(densities[d] * length);
+            const unsigned seed = 7919u * length + d;
+
+            BinaryRelation expected(length);
+            Fill(&expected, length, edges, seed, 0);
+            expected.makeTransitive(BinaryRelation::WARSHALL);
+
+            for (int a = 0; a < numAlgorithms; ++a) {
+                // Build the relation both at its final size and by
+                // growth, so that spare capacity past the last word
+                // of a row is exercised too.
+                for (int growFlag = 0; growFlag <= 1; ++growFlag) {
+                    BinaryRelation rel(growFlag ? 0 : length);
+                    Fill(&rel, length, edges, seed, growFlag);
+                    rel.makeTransitive(algorithms[a]);
+                    ++cases;
+                    if (rel != expected) {
+                        printf("FAIL: %s differs from WARSHALL "
+                               "(length %d, %d edges, %s)\n",
+                               Name(algorithms[a]), length, edges,
+                               growFlag ? "grown" : "sized");
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%d of %d closures agree with WARSHALL.\n",
+           cases - failures, cases);
+
+    // Reduce both general relations and acyclic ones (whose 1's all lie
+    // above the diagonal), which have a unique reduction.
+    const int reductionFailures = failures;
+    const int reductionCases = cases;
+    for (int s = 0; s < numSizes && sizes[s] <= 513; ++s) {
+        for (int d = 0; d < numDensities; ++d) {
+            for (int acyclicFlag = 0; acyclicFlag <= 1; ++acyclicFlag) {
+                const int length = sizes[s];
+                const int edges = int(densities[d] * length);
+                const unsigned seed = 7919u * length + d;
+
+                BinaryRelation closed(length);
+                unsigned state = seed;
+                for (int e = 0; length && e < edges; ++e) {
+                    int row = Random(&state) % length;
+                    int col = Random(&state) % length;
+                    if (acyclicFlag && row >= col) {
+                        continue;
+                    }
+                    closed.set(row, col);
+                }
+                closed.makeTransitive();
+
+                BinaryRelation reduced(closed);
+                reduced.makeNonTransitive();
+                ++cases;
+                if (!IsReduction(reduced, closed, acyclicFlag)) {
+                    printf("FAIL: makeNonTransitive is not a reduction "
+                           "(length %d, %d edges, %s)\n",
+                           length, edges, acyclicFlag ? "acyclic" : "cyclic");
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    printf("%d of %d reductions are correct.\n",
+           cases - reductionCases - (failures - reductionFailures),
+           cases - reductionCases);
+
+    // Insert random edges, one at a time, into a closed relation; after
+    // each insertion the result must be the closure of the relation with
+    // that edge set.
+    const int insertionFailures = failures;
+    const int insertionCases = cases;
+    for (int s = 0; s < numSizes && sizes[s] <= 1000; ++s) {
+        for (int d = 0; d < numDensities; ++d) {
+            const int length = sizes[s];
+            if (0 == length) {
+                continue;
+            }
+            const int edges = int(densities[d] * length);
+            const unsigned seed = 7919u * length + d;
+
+            BinaryRelation rel(length);
+            Fill(&rel, length, edges / 2, seed, 0);
+            BinaryRelation expected(rel);
+            rel.makeTransitive();
+
+            unsigned state = ~seed;
+            for (int e = 0; e < 8; ++e) {
+                int row = Random(&state) % length;
+                int col = Random(&state) % length;
+                rel.insertEdgeClosed(row, col);
+                expected.set(row, col);
+                BinaryRelation closed(expected);
+                closed.makeTransitive(BinaryRelation::WARSHALL);
+                ++cases;
+                if (rel != closed) {
+                    printf("FAIL: insertEdgeClosed(%d, %d) differs from "
+                           "makeTransitive (length %d, %d edges)\n",
+                           row, col, length, edges / 2 + e);
+                    ++failures;
+                    break;
+                }
+            }
+        }
+    }
+
+    printf("%d of %d insertions agree with makeTransitive.\n",
+           cases - insertionCases - (failures - insertionFailures),
+           cases - insertionCases);
+
+    failures += CheckValueSemantics();
+    return failures;
+}
@@ -0,0 +1,307 @@
+#include "idep_char_scan.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IDEP_CHAR_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// IMPLEMENTATION NOTE: As in idep_row_kernel, the vector kernels are
+// compiled with per-function target attributes and only called after
+// cpuid has confirmed support.  Each compares a full vector of characters
+// against the class, turns the result into a bit mask (one bit per
+// character) and returns the position of the lowest set bit; characters
+// left over after the last full vector are handled by the scalar kernel.
+// White space is ' ' or a character in ['\t' .. '\r'], and the range
+// test is done without signed compares: c - '\t' (wrapping) is at most
+// '\r' - '\t' exactly when min(c - '\t', '\r' - '\t') == c - '\t'.
+
+namespace {
+
+typedef const char* (*ClassOp)(const char* begin, const char* end);
+typedef const char* (*CharOp)(const char* begin, const char* end, char c);
+
+enum { RANGE = '\r' - '\t' };
+
+const char* FindSpaceScalar(const char* begin, const char* end) {
+  while (begin < end && !idep::CharScan::IsSpace(*begin))
+    ++begin;
+  return begin;
+}
+
+const char* SkipBlanksScalar(const char* begin, const char* end) {
+  while (begin < end && idep::CharScan::IsSpace(*begin) && '\n' != *begin)
+    ++begin;
+  return begin;
+}
+
+const char* FindCharScalar(const char* begin, const char* end, char c) {
+  // The C library's memchr() is usually vectorized already; it serves as
+  // the scalar kernel so that the fallback is no slower than before.
+  const void* p = memchr(begin, c, end - begin);
+  return p ? static_cast<const char*>(p) : end;
+}
+
+#if IDEP_CHAR_SCAN_X86
+
+__attribute__((target("sse2")))
+inline unsigned SpaceMaskSse2(__m128i v) {
+  const __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+  const __m128i in_range = _mm_cmpeq_epi8(
+      _mm_min_epu8(shifted, _mm_set1_epi8(RANGE)), shifted);
+  const __m128i blank = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  return _mm_movemask_epi8(_mm_or_si128(in_range, blank));
+}
+
+__attribute__((target("sse2")))
+const char* FindSpaceSse2(const char* begin, const char* end) {
+  for (; end - begin >= 16; begin += 16) {
+    const unsigned mask = SpaceMaskSse2(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)));
+    if (mask)
+      return begin + __builtin_ctz(mask);
+  }
+  return FindSpaceScalar(begin, end);
+}
+
+__attribute__((target("sse2")))
+const char* SkipBlanksSse2(const char* begin, const char* end) {
+  for (; end - begin >= 16; begin += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const unsigned newline = _mm_movemask_epi8(
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    const unsigned other = ~(SpaceMaskSse2(v) & ~newline) & 0xffff;
+    if (other)
+      return begin + __builtin_ctz(other);
+  }
+  return SkipBlanksScalar(begin, end);
+}
+
+__attribute__((target("sse2")))
+const char* FindCharSse2(const char* begin, const char* end, char c) {
+  const __m128i target = _mm_set1_epi8(c);
+  for (; end - begin >= 16; begin += 16) {
+    const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), target));
+    if (mask)
+      return begin + __builtin_ctz(mask);
+  }
+  return FindCharScalar(begin, end, c);
+}
+
+__attribute__((target("avx2")))
+inline unsigned SpaceMaskAvx2(__m256i v) {
+  const __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+  const __m256i in_range = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(shifted, _mm256_set1_epi8(RANGE)), shifted);
+  const __m256i blank = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+  return _mm256_movemask_epi8(_mm256_or_si256(in_range, blank));
+}
+
+__attribute__((target("avx2")))
+const char* FindSpaceAvx2(const char* begin, const char* end) {
+  for (; end - begin >= 32; begin += 32) {
+    const unsigned mask = SpaceMaskAvx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)));
+    if (mask)
+      return begin + __builtin_ctz(mask);
+  }
+  return FindSpaceScalar(begin, end);
+}
+
+__attribute__((target("avx2")))
+const char* SkipBlanksAvx2(const char* begin, const char* end) {
+  for (; end - begin >= 32; begin += 32) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    const unsigned newline = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    const unsigned other = ~(SpaceMaskAvx2(v) & ~newline);
+    if (other)
+      return begin + __builtin_ctz(other);
+  }
+  return SkipBlanksScalar(begin, end);
+}
+
+__attribute__((target("avx2")))
+const char* FindCharAvx2(const char* begin, const char* end, char c) {
+  const __m256i target = _mm256_set1_epi8(c);
+  for (; end - begin >= 32; begin += 32) {
+    const unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)), target));
+    if (mask)
+      return begin + __builtin_ctz(mask);
+  }
+  return FindCharScalar(begin, end, c);
+}
+
+__attribute__((target("avx512bw")))
+inline unsigned long long SpaceMaskAvx512(__m512i v) {
+  const __m512i shifted = _mm512_sub_epi8(v, _mm512_set1_epi8('\t'));
+  return _mm512_cmple_epu8_mask(shifted, _mm512_set1_epi8(RANGE)) |
+         _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' '));
+}
+
+__attribute__((target("avx512bw")))
+const char* FindSpaceAvx512(const char* begin, const char* end) {
+  for (; end - begin >= 64; begin += 64) {
+    const unsigned long long mask =
+        SpaceMaskAvx512(_mm512_loadu_si512(begin));
+    if (mask)
+      return begin + __builtin_ctzll(mask);
+  }
+  return FindSpaceScalar(begin, end);
+}
+
+__attribute__((target("avx512bw")))
+const char* SkipBlanksAvx512(const char* begin, const char* end) {
+  for (; end - begin >= 64; begin += 64) {
+    const __m512i v = _mm512_loadu_si512(begin);
+    const unsigned long long newline =
+        _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n'));
+    const unsigned long long other = ~(SpaceMaskAvx512(v) & ~newline);
+    if (other)
+      return begin + __builtin_ctzll(other);
+  }
+  return SkipBlanksScalar(begin, end);
+}
+
+__attribute__((target("avx512bw")))
+const char* FindCharAvx512(const char* begin, const char* end, char c) {
+  const __m512i target = _mm512_set1_epi8(c);
+  for (; end - begin >= 64; begin += 64) {
+    const unsigned long long mask =
+        _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(begin), target);
+    if (mask)
+      return begin + __builtin_ctzll(mask);
+  }
+  return FindCharScalar(begin, end, c);
+}
+
+#endif  // IDEP_CHAR_SCAN_X86
+
+struct KernelEntry {
+  const char* name;
+  ClassOp find_space;
+  ClassOp skip_blanks;
+  CharOp find_char;
+};
+
+const KernelEntry kKernels[idep::CharScan::NUM_KINDS] = {
+  { "auto",   0,                0,                 0              },
+  { "scalar", FindSpaceScalar,  SkipBlanksScalar,  FindCharScalar },
+#if IDEP_CHAR_SCAN_X86
+  { "sse2",   FindSpaceSse2,    SkipBlanksSse2,    FindCharSse2   },
+  { "avx2",   FindSpaceAvx2,    SkipBlanksAvx2,    FindCharAvx2   },
+  { "avx512", FindSpaceAvx512,  SkipBlanksAvx512,  FindCharAvx512 },
+#else
+  { "sse2",   0,                0,                 0              },
+  { "avx2",   0,                0,                 0              },
+  { "avx512", 0,                0,                 0              },
+#endif
+};
+
+const char* ResolveFindSpace(const char* begin, const char* end);
+const char* ResolveSkipBlanks(const char* begin, const char* end);
+const char* ResolveFindChar(const char* begin, const char* end, char c);
+
+// Until a kernel is selected, the entry points resolve to the best
+// available kernel on first use.
+idep::CharScan::Kind s_current = idep::CharScan::AUTO;
+ClassOp s_find_space = ResolveFindSpace;
+ClassOp s_skip_blanks = ResolveSkipBlanks;
+CharOp s_find_char = ResolveFindChar;
+
+const char* ResolveFindSpace(const char* begin, const char* end) {
+  idep::CharScan::Select(idep::CharScan::AUTO);
+  return s_find_space(begin, end);
+}
+
+const char* ResolveSkipBlanks(const char* begin, const char* end) {
+  idep::CharScan::Select(idep::CharScan::AUTO);
+  return s_skip_blanks(begin, end);
+}
+
+const char* ResolveFindChar(const char* begin, const char* end, char c) {
+  idep::CharScan::Select(idep::CharScan::AUTO);
+  return s_find_char(begin, end, c);
+}
+
+}  // namespace
+
+namespace idep {
+
+const char* CharScan::FindSpace(const char* begin, const char* end) {
+  return s_find_space(begin, end);
+}
+
+const char* CharScan::SkipBlanks(const char* begin, const char* end) {
+  return s_skip_blanks(begin, end);
+}
+
+const char* CharScan::FindChar(const char* begin, const char* end, char c) {
+  return s_find_char(begin, end, c);
+}
+
+bool CharScan::IsSupported(Kind kind) {
+  switch (kind) {
+    case AUTO:
+    case SCALAR:
+      return true;
+#if IDEP_CHAR_SCAN_X86
+    case SSE2:
+      return __builtin_cpu_supports("sse2");
+    case AVX2:
+      return __builtin_cpu_supports("avx2");
+    case AVX512:
+      return __builtin_cpu_supports("avx512bw");
+#endif
+    default:
+      return false;
+  }
+}
+
+bool CharScan::Select(Kind kind) {
+  if (kind < 0 || kind >= NUM_KINDS || !IsSupported(kind))
+    return false;
+
+  if (AUTO == kind) {
+    kind = SCALAR;
+    for (int k = NUM_KINDS - 1; k > SCALAR; --k) {
+      if (IsSupported(static_cast<Kind>(k))) {
+        kind = static_cast<Kind>(k);
+        break;
+      }
+    }
+  }
+
+  assert(kKernels[kind].find_space && kKernels[kind].skip_blanks &&
+         kKernels[kind].find_char);
+  s_current = kind;
+  s_find_space = kKernels[kind].find_space;
+  s_skip_blanks = kKernels[kind].skip_blanks;
+  s_find_char = kKernels[kind].find_char;
+  return true;
+}
+
+bool CharScan::Select(const char* name) {
+  for (int k = 0; k < NUM_KINDS; ++k) {
+    if (0 == strcmp(name, kKernels[k].name))
+      return Select(static_cast<Kind>(k));
+  }
+  return false;
+}
+
+CharScan::Kind CharScan::Current() {
+  if (AUTO == s_current)
+    Select(AUTO);
+  return s_current;
+}
+
+const char* CharScan::Name(Kind kind) {
+  return kind >= 0 && kind < NUM_KINDS ? kKernels[kind].name : 0;
+}
+
+}  // namespace idep
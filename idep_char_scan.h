@@ -0,0 +1,65 @@
+#ifndef IDEP_CHAR_SCAN_H_
+#define IDEP_CHAR_SCAN_H_
+
+namespace idep {
+
+// This leaf component defines 1 utility class:
+// Searches of character ranges for the classes of characters that the
+// tokenizer and the include scanner care about.  Each search is carried
+// out by one of several kernels (scalar, SSE2, AVX2, AVX-512) that
+// examine 1, 16, 32 or 64 characters at a time; by default the widest
+// kernel supported by the processor is chosen at run time via cpuid.
+//
+// "White space" is what isspace() accepts in the "C" locale, i.e., ' ',
+// '\t', '\n', '\v', '\f' and '\r'; a "blank" is any of these but '\n'.
+// Each search examines the characters in [begin, end) and returns end if
+// none qualifies; none reads outside that range.
+class CharScan {
+ public:
+  enum Kind {
+    AUTO,         // widest kernel supported by this processor
+    SCALAR,       // portable loop
+    SSE2,         // 128-bit vectors
+    AVX2,         // 256-bit vectors
+    AVX512,       // 512-bit vectors (AVX-512BW)
+    NUM_KINDS     // must be last entry
+  };
+
+  // Return true if the specified character is white space.
+  static bool IsSpace(char c) {
+    return ' ' == c || ('\t' <= c && c <= '\r');
+  }
+
+  // Return the first white-space character in [begin, end).
+  static const char* FindSpace(const char* begin, const char* end);
+
+  // Return the first character in [begin, end) that is not a blank.
+  static const char* SkipBlanks(const char* begin, const char* end);
+
+  // Return the first occurrence of the specified character in
+  // [begin, end).
+  static const char* FindChar(const char* begin, const char* end, char c);
+
+  // Use the specified kernel for all subsequent searches.  Return true
+  // on success, and false (leaving the current selection unchanged) if
+  // this processor does not support that kernel.
+  static bool Select(Kind kind);
+
+  // Same as above, but the kernel is identified by its name ("auto",
+  // "scalar", "sse2", "avx2" or "avx512").  Return false if the name is
+  // unknown or the kernel is not supported.
+  static bool Select(const char* name);
+
+  // Return true if this processor can run the specified kernel.
+  static bool IsSupported(Kind kind);
+
+  // Return the kernel currently in use (never AUTO).
+  static Kind Current();
+
+  // Return the name of the specified kernel.
+  static const char* Name(Kind kind);
+};
+
+}  // namespace idep
+
+#endif  // IDEP_CHAR_SCAN_H_
@@ -3,14 +3,21 @@
 #include <assert.h>
 #include <ctype.h>
 #include <string.h>
+#include <sys/stat.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
-#include "idep_binary_relation.h"
+#include "idep_condensation.h"
 #include "idep_file_dep_iterator.h"
+#include "idep_file_loader.h"
+#include "idep_macro_table.h"
 #include "idep_name_array.h"
 #include "idep_name_index_map.h"
+#include "idep_scan_cache.h"
+#include "idep_sparse_relation.h"
 #include "idep_token_iterator.h"
 
 namespace idep {
@@ -103,6 +110,323 @@ static const char* search(std::string* s,
     return dir_file;
 }
 
+                // -*-*-*- Prescan -*-*-*-
+
+// When files are loaded asynchronously, every file that the calculation
+// will visit is loaded and scanned up front, in whatever order the loads
+// finish, and the include names found in each file, as well as the file
+// that each name resolves to, are recorded.  The recursive visit in
+// getDep() then takes the includes of each file from this record instead
+// of reading the file, so that the resulting relation (and the order of
+// any error messages) is the same as when each file is read as it is
+// visited.  A name is resolved by a single request whose candidates are
+// the name in each include directory, in order; as with search(), the
+// first one that can be opened wins.  Without a cache, that request also
+// loads the file found.  With a cache, it only opens it, and the file is
+// loaded by a request of its own only if the cache does not have it.
+
+enum { NOT_FOUND = -1, PENDING = -2 };
+enum { START_SIZE = 64, GROW_FACTOR = 2 };
+
+template <typename T> static T *resize(T *array, int length, int size) {
+    T *tmp = new T[size];
+    memcpy(tmp, array, length * sizeof *tmp);
+    delete[] array;
+    return tmp;
+}
+
+struct PrescanFile {
+    int d_firstInclude;         // index of first include in d_includes_p
+    int d_numIncludes;
+    int d_numSkipped;           // includes skipped as inactive
+    bool d_valid;               // whether the file could be opened
+    bool d_scanned;             // whether the above are known
+    bool d_requested;           // whether the file is being loaded
+    struct stat d_status;       // identity before loading, with a cache
+};
+
+struct Prescan {
+    idep::NameIndexMap d_files;         // every file found, by path
+    PrescanFile *d_files_p;             // scan of each file
+    int d_fileSize;                     // physical size of d_files_p
+
+    idep::NameIndexMap d_names;         // every include name found
+    int *d_resolved_p;                  // file of each name, or NOT_FOUND
+    int d_nameSize;                     // physical size of d_resolved_p
+
+    int *d_includes_p;                  // names included by each file
+    int d_numIncludes;
+    int d_includeSize;                  // physical size of d_includes_p
+
+    // settings of the current run()
+    const idep::NameArray *d_includeDirectories_p;
+    bool d_recurse;
+    const idep::MacroTable *d_macros_p;
+    idep::ScanCache *d_cache_p;
+    idep::FileLoader *d_loader_p;
+
+    Prescan();
+    ~Prescan();
+
+    // Load and scan the specified root files and, if so specified, every
+    // file that they include directly or indirectly, resolving names
+    // against the specified include directories.  Take the names in
+    // files from the specified cache, if any, when it has them, and add
+    // those of the files scanned to it.
+    void run(const idep::NameIndexMap& roots,
+             int numRoots,
+             const idep::NameArray& includeDirectories,
+             bool recurse,
+             const idep::MacroTable *macros,
+             idep::ScanCache *cache,
+             idep::FileLoader::Engine engine);
+
+    // Return the index of the file having the specified path, adding it
+    // (as not yet scanned) if needed.
+    int fileEntry(const char *path);
+
+    // Take the names in the specified file from the cache if possible,
+    // and request that the file be loaded otherwise.
+    void request(int file);
+
+    // Record the specified name as the next include of the current file,
+    // and request that the name be resolved if it was not seen before.
+    void addInclude(const char *name);
+
+    // Record the includes in the specified contents of the specified
+    // file, adopting the contents, or (if contents is 0 and length is -1)
+    // that the file could not be opened.
+    void scan(int file, char *contents, int length);
+
+    // Record the includes of the specified file as found in the specified
+    // cache entry.
+    void recall(int file, int entry);
+};
+
+Prescan::Prescan()
+    : d_files_p(new PrescanFile[START_SIZE]),
+      d_fileSize(START_SIZE),
+      d_resolved_p(new int[START_SIZE]),
+      d_nameSize(START_SIZE),
+      d_includes_p(new int[START_SIZE]),
+      d_numIncludes(0),
+      d_includeSize(START_SIZE) {
+}
+
+Prescan::~Prescan() {
+    delete[] d_files_p;
+    delete[] d_resolved_p;
+    delete[] d_includes_p;
+}
+
+int Prescan::fileEntry(const char *path) {
+    const int length = d_files.Length();
+    const int file = d_files.Entry(path);
+    if (d_files.Length() > length) {
+        if (file >= d_fileSize) {
+            d_files_p = resize(d_files_p, length, d_fileSize * GROW_FACTOR);
+            d_fileSize *= GROW_FACTOR;
+        }
+        d_files_p[file].d_scanned = false;
+        d_files_p[file].d_requested = false;
+    }
+    return file;
+}
+
+void Prescan::request(int file) {
+    PrescanFile& f = d_files_p[file];
+    if (f.d_scanned || f.d_requested) {
+        return;
+    }
+    const char *path = d_files[file];
+    if (d_cache_p && 0 == stat(path, &f.d_status)) {
+        const int entry = d_cache_p->Find(path, f.d_status);
+        if (entry >= 0) {
+            recall(file, entry);
+            return;
+        }
+    }
+    f.d_requested = true;
+    d_loader_p->Submit(2 * file + 1, &path, 1, true);
+}
+
+void Prescan::addInclude(const char *includeName) {
+    const int numNames = d_names.Length();
+    const int name = d_names.Entry(includeName);
+    if (d_names.Length() > numNames) {
+        if (name >= d_nameSize) {
+            d_resolved_p = resize(d_resolved_p, numNames,
+                                  d_nameSize * GROW_FACTOR);
+            d_nameSize *= GROW_FACTOR;
+        }
+        d_resolved_p[name] = PENDING;
+
+        const bool load = d_recurse && !d_cache_p;
+        if (IsAbsolutePath(includeName)) {
+            d_loader_p->Submit(2 * name, &includeName, 1, load);
+        } else {
+            const idep::NameArray& dirs = *d_includeDirectories_p;
+            idep::NameArray candidates;
+            std::string buffer;
+            for (int i = 0; i < dirs.Length(); ++i) {
+                (buffer = dirs[i]) += includeName;
+                candidates.Append(stripDotSlash(buffer.c_str()));
+            }
+            const char **names = new const char *[candidates.Length()];
+            for (int i = 0; i < candidates.Length(); ++i) {
+                names[i] = candidates[i];
+            }
+            d_loader_p->Submit(2 * name, names, candidates.Length(), load);
+            delete[] names;
+        }
+    }
+
+    if (d_numIncludes >= d_includeSize) {
+        d_includes_p = resize(d_includes_p, d_numIncludes,
+                              d_includeSize * GROW_FACTOR);
+        d_includeSize *= GROW_FACTOR;
+    }
+    d_includes_p[d_numIncludes++] = name;
+}
+
+void Prescan::scan(int file, char *contents, int length) {
+    const int firstInclude = d_numIncludes;
+    const bool valid = length >= 0;
+
+    idep::FileDepIterator it(contents, valid ? length : 0, d_macros_p);
+    idep::NameArray names;
+    for (; it; ++it) {
+        addInclude(it());
+        if (d_cache_p) {
+            names.Append(it());
+        }
+    }
+    if (d_cache_p && valid && d_files_p[file].d_requested) {
+        d_cache_p->Add(d_files[file], d_files_p[file].d_status, names,
+                       it.NumSkipped());
+    }
+
+    PrescanFile& f = d_files_p[file];
+    f.d_firstInclude = firstInclude;
+    f.d_numIncludes = d_numIncludes - firstInclude;
+    f.d_numSkipped = it.NumSkipped();
+    f.d_valid = valid;
+    f.d_scanned = true;
+}
+
+void Prescan::recall(int file, int entry) {
+    const int firstInclude = d_numIncludes;
+    for (int i = 0; i < d_cache_p->NumNames(entry); ++i) {
+        addInclude(d_cache_p->Name(entry, i));
+    }
+
+    PrescanFile& f = d_files_p[file];
+    f.d_firstInclude = firstInclude;
+    f.d_numIncludes = d_numIncludes - firstInclude;
+    f.d_numSkipped = d_cache_p->NumSkipped(entry);
+    f.d_valid = true;
+    f.d_scanned = true;
+}
+
+void Prescan::run(const idep::NameIndexMap& roots,
+                  int numRoots,
+                  const idep::NameArray& includeDirectories,
+                  bool recurse,
+                  const idep::MacroTable *macros,
+                  idep::ScanCache *cache,
+                  idep::FileLoader::Engine engine) {
+    idep::FileLoader loader(engine);
+    d_includeDirectories_p = &includeDirectories;
+    d_recurse = recurse;
+    d_macros_p = macros;
+    d_cache_p = cache;
+    d_loader_p = &loader;
+
+    // Names are tagged by twice their index, and files by one more than
+    // twice theirs.
+
+    for (int i = 0; i < numRoots; ++i) {
+        request(fileEntry(roots[i]));
+    }
+
+    std::string buffer;
+    idep::FileLoader::Result result;
+    while (loader.Next(&result)) {
+        const int index = result.tag / 2;
+        if (result.tag % 2) {
+            scan(index, result.contents,
+                 result.candidate < 0 ? -1 : result.length);
+            continue;
+        }
+
+        const char *name = d_names[index];
+        if (result.candidate < 0) {
+            d_resolved_p[index] = NOT_FOUND;
+            continue;
+        }
+        int file;
+        if (IsAbsolutePath(name)) {
+            file = fileEntry(name);
+        } else {
+            (buffer = includeDirectories[result.candidate]) += name;
+            file = fileEntry(stripDotSlash(buffer.c_str()));
+        }
+        d_resolved_p[index] = file;
+
+        if (result.contents && !d_files_p[file].d_scanned &&
+                                                !d_files_p[file].d_requested) {
+            scan(file, result.contents, result.length);
+        } else {
+            delete[] result.contents;
+            if (d_recurse) {
+                request(file);
+            }
+        }
+    }
+    d_loader_p = 0;
+
+    // The loader hands back every request submitted, whatever its engine
+    // does, so no name is left unresolved.
+    for (int i = 0; i < d_names.Length(); ++i) {
+        assert(PENDING != d_resolved_p[i]);
+    }
+}
+
+// Iterate over the includes recorded for one file by a Prescan, in the
+// manner of a FileDepIterator.
+class PrescanIterator {
+    const Prescan& d_scan;
+    const PrescanFile& d_file;
+    int d_index;                // index of current include of d_file
+
+  public:
+    PrescanIterator(const Prescan& scan, int file)
+        : d_scan(scan), d_file(scan.d_files_p[file]), d_index(0) {}
+
+    bool IsValidFile() const { return d_file.d_valid; }
+    void operator++() { ++d_index; }
+    operator const void *() const {
+        return d_index < d_file.d_numIncludes ? this : 0;
+    }
+    const char *operator()() const { return d_scan.d_names[name()]; }
+    int NumSkipped() const { return d_file.d_numSkipped; }
+
+    // Return the path of the file that the current include resolves to,
+    // or 0 if it was not found.  Every name has been resolved by the time
+    // Prescan::run returns, so that a name still PENDING cannot be taken
+    // for one that was not found.
+    const char *resolved() const {
+        const int file = d_scan.d_resolved_p[name()];
+        assert(PENDING != file);
+        return file >= 0 ? d_scan.d_files[file] : 0;
+    }
+
+  private:
+    int name() const {
+        return d_scan.d_includes_p[d_file.d_firstInclude + d_index];
+    }
+};
+
                 // -*-*-*- static recursive functions -*-*-*-
 
 // The following temporary, file-scope pointer variables are used 
@@ -110,20 +434,34 @@ static const char* search(std::string* s,
 // in order to avoid the unnecessary time and space costs of passing 
 // several invariant arguments on the program stack.
 
-static idep::BinaryRelation *s_dependencies_p;   // set just before first call to getDep
+static idep::SparseRelation *s_dependencies_p;   // set just before first call to getDep
 static idep::NameIndexMap *s_files_p;    // set just before first call to getDep
 static idep::NameArray *s_includes_p;    // set just before first call to getDep
 static bool s_recurse;                   // set just before first call to getDep
 static std::ostream *s_err_p;                // set just before first call to getDep
+static const idep::MacroTable *s_macros_p;   // set just before first call to getDep
+static int *s_skipped_p;                 // set just before first call to getDep
+static const Prescan *s_prescan_p;       // set just before first call to getDep
+static idep::ScanCache *s_cache_p;       // set just before first call to getDep
 
-static int getDep(int index) {
+static int getDep(int index);
+
+static const char *resolve(std::string *buffer,
+                           const idep::ScanCacheIterator& it) {
+    return search(buffer, *s_includes_p, it());
+}
+
+static const char *resolve(std::string *, const PrescanIterator& it) {
+    return it.resolved();
+}
+
+template <typename Iterator> static int visitDeps(int index, Iterator& it) {
     enum { BAD = -1, GOOD = 0 } status = GOOD;
 
     std::string buffer; // string buffer, do not use directly
 
-    idep::FileDepIterator it((*s_files_p)[index]);
-    for (it; it; ++it) {
-        const char *dirFile = search(&buffer, *s_includes_p, it());
+    for (; it; ++it) {
+        const char *dirFile = resolve(&buffer, it);
         if (!dirFile) {
             err(*s_err_p) << "include directory for file \""
                  << it() << "\" not specified." << std::endl;
@@ -143,9 +481,11 @@ static int getDep(int index) {
             }
         }
 
-        s_dependencies_p->set(index, otherIndex, 1);
+        s_dependencies_p->set(index, otherIndex);
     }
 
+    *s_skipped_p += it.NumSkipped();
+
     if (!it.IsValidFile()) {
        err(*s_err_p) << "unable to open file \""
          << (*s_files_p)[index] << "\" for read access." << std::endl;
@@ -155,6 +495,19 @@ static int getDep(int index) {
     return status;
 }
 
+static int getDep(int index) {
+    const char *name = (*s_files_p)[index];
+    const int file = s_prescan_p ? s_prescan_p->d_files.GetIndexByName(name)
+                                 : -1;
+    if (file >= 0 && s_prescan_p->d_files_p[file].d_scanned) {
+        PrescanIterator it(*s_prescan_p, file);
+        return visitDeps(index, it);
+    }
+
+    idep::ScanCacheIterator it(s_cache_p, name, s_macros_p);
+    return visitDeps(index, it);
+}
+
                 // -*-*-*- CompileDepImpl -*-*-*-
 
 struct CompileDepImpl {
@@ -162,23 +515,39 @@ struct CompileDepImpl {
     idep::NameArray d_rootFiles;               // files to be analyzed
 
     idep::NameIndexMap *d_fileNames_p;         // keys for relation
-    idep::BinaryRelation *d_dependencies_p;            // compile-time dependencies
+    idep::SparseRelation *d_edges_p;           // direct dependencies
+    idep::Condensation *d_condensation_p;      // their closure, if recursive
     int d_numRootFiles;                       // number of roots in relation
 
+    idep::MacroTable d_macros;                 // from -D and -U options
+    bool d_skipInactive;                       // whether to use d_macros
+    int d_numSkipped;                          // inactive includes skipped
+
+    bool d_async;                              // whether to use a Prescan
+    idep::FileLoader::Engine d_engine;         // engine for the Prescan
+
+    std::string d_cacheFile;                   // empty if not caching
+
     CompileDepImpl();
     ~CompileDepImpl();
 };
 
 CompileDepImpl::CompileDepImpl()
     : d_fileNames_p(0),
-      d_dependencies_p(0),
-      d_numRootFiles(-1) {
+      d_edges_p(0),
+      d_condensation_p(0),
+      d_numRootFiles(-1),
+      d_skipInactive(false),
+      d_numSkipped(0),
+      d_async(false),
+      d_engine(idep::FileLoader::AUTO) {
 }
 
 CompileDepImpl::~CompileDepImpl()
 {
     delete d_fileNames_p;
-    delete d_dependencies_p;
+    delete d_edges_p;
+    delete d_condensation_p;
 }
 
                 // -*-*-*- CompileDep -*-*-*-
@@ -251,17 +620,44 @@ void CompileDep::InputRootFiles() {
     }
 }
 
+void CompileDep::SetSkipInactiveIncludes(bool skip_flag) {
+    d_this->d_skipInactive = skip_flag;
+}
+
+void CompileDep::DefineMacro(const char* definition) {
+    d_this->d_macros.Define(definition);
+}
+
+void CompileDep::UndefineMacro(const char* name) {
+    d_this->d_macros.Undefine(name);
+}
+
+void CompileDep::SetCacheFile(const char* file_name) {
+    d_this->d_cacheFile = file_name ? file_name : "";
+}
+
+void CompileDep::SetAsynchronousLoading(bool async_flag,
+                                        FileLoader::Engine engine) {
+    d_this->d_async = async_flag;
+    d_this->d_engine = engine;
+}
+
 bool CompileDep::Calculate(std::ostream& orf, bool recursionFlag) {
     bool success = true;
 
     // clean up any previous calculation artifacts
     delete d_this->d_fileNames_p;
-    delete d_this->d_dependencies_p;
+    delete d_this->d_edges_p;
+    delete d_this->d_condensation_p;
 
-    // allocate new data structures for this calculation
+    // allocate new data structures for this calculation; dependencies are
+    // collected sparsely and closed, if need be, once at the end
     d_this->d_fileNames_p = new idep::NameIndexMap;
-    d_this->d_dependencies_p = new idep::BinaryRelation;
+    d_this->d_edges_p = new idep::SparseRelation;
+    d_this->d_condensation_p = 0;
     d_this->d_numRootFiles = 0;
+    d_this->d_numSkipped = 0;
+    idep::SparseRelation& edges = *d_this->d_edges_p;
 
 
     // place all root files at the start of the relation
@@ -283,7 +679,7 @@ bool CompileDep::Calculate(std::ostream& orf, bool recursionFlag) {
         }
         else {
             ++d_this->d_numRootFiles;
-            d_this->d_dependencies_p->appendEntry();
+            edges.appendEntry();
         }
     }
 
@@ -291,11 +687,41 @@ bool CompileDep::Calculate(std::ostream& orf, bool recursionFlag) {
     // translation unit recursively.  First we will set up several
     // file-scope pointers to reduce recursive overhead.
 
-    s_dependencies_p = d_this->d_dependencies_p;
+    s_dependencies_p = &edges;
     s_files_p = d_this->d_fileNames_p;
     s_includes_p = &d_this->d_includeDirectories;
     s_recurse = recursionFlag;
     s_err_p = &orf;
+    s_macros_p = d_this->d_skipInactive ? &d_this->d_macros : 0;
+    s_skipped_p = &d_this->d_numSkipped;
+
+    // The includes found in a file depend on the macros, if any, so the
+    // cache keeps them apart.
+
+    std::ostringstream configuration;
+    if (s_macros_p) {
+        configuration << "-c" << std::endl << *s_macros_p;
+    }
+    idep::ScanCache cache(configuration.str().c_str());
+    s_cache_p = 0;
+    if (!d_this->d_cacheFile.empty()) {
+        if (!cache.Load(d_this->d_cacheFile.c_str())) {
+            err(orf) << "ignoring invalid cache file \""
+                     << d_this->d_cacheFile << "\"." << std::endl;
+        }
+        s_cache_p = &cache;
+    }
+
+    // Optionally load and scan all the files to be visited at once first.
+
+    Prescan prescan;
+    s_prescan_p = 0;
+    if (d_this->d_async) {
+        prescan.run(*d_this->d_fileNames_p, d_this->d_numRootFiles,
+                    d_this->d_includeDirectories, recursionFlag, s_macros_p,
+                    s_cache_p, d_this->d_engine);
+        s_prescan_p = &prescan;
+    }
 
     // Each translation unit forms the root of a tree of dependencies.
     // We will visit each node only once, recording the results as we go.
@@ -310,12 +736,22 @@ bool CompileDep::Calculate(std::ostream& orf, bool recursionFlag) {
         }
     }
 
+    if (s_cache_p && !cache.Save(d_this->d_cacheFile.c_str())) {
+        err(orf) << "unable to write cache file \""
+                 << d_this->d_cacheFile << "\"." << std::endl;
+    }
+
+    edges.freeze();
     if (recursionFlag)
-        d_this->d_dependencies_p->makeTransitive();
+        d_this->d_condensation_p = new idep::Condensation(edges);
 
     return success;
 }
 
+int CompileDep::NumSkippedIncludes() const {
+    return d_this->d_numSkipped;
+}
+
 std::ostream& operator<<(std::ostream& o, const CompileDep& dep)
 {
     const char *INDENT = "    ";
@@ -381,22 +817,58 @@ const char *RootFileIterator::operator()() const
                 // -*-*-*- HeaderFileIteratorImpl -*-*-*-
 
 struct HeaderFileIteratorImpl {
-  const RootFileIteratorImpl& d_iter;
+  const idep::NameIndexMap& d_names;
+  int *d_files_p;       // files on which the root file depends, in order
+  int d_numFiles;
   int d_index;
 
   HeaderFileIteratorImpl(const RootFileIteratorImpl& iter);
+  ~HeaderFileIteratorImpl();
 };
 
 HeaderFileIteratorImpl::HeaderFileIteratorImpl(const RootFileIteratorImpl& iter)
-    : d_iter(iter),
-      d_index(-1) {
+    : d_names(*iter.d_dep.d_fileNames_p),
+      d_files_p(0),
+      d_numFiles(0),
+      d_index(0) {
+  // The files are those the root file includes, or if the dependencies
+  // are recursive, the members of every strong component it reaches.
+  const idep::SparseRelation& edges = *iter.d_dep.d_edges_p;
+  const idep::Condensation *scc = iter.d_dep.d_condensation_p;
+  const int root = iter.d_index;
+
+  if (!scc) {
+    d_numFiles = edges.numSuccessors(root);
+    d_files_p = new int[d_numFiles + 1];
+    memcpy(d_files_p, edges.successors(root), d_numFiles * sizeof *d_files_p);
+    return;
+  }
+
+  const int c = scc->component(root);
+  int *reached = new int[scc->numReached(c) + 1];
+  const int numReached = scc->reached(c, reached);
+  for (int i = 0; i < numReached; ++i) {
+    d_numFiles += scc->numMembers(reached[i]);
+  }
+  d_files_p = new int[d_numFiles + 1];
+  int *f = d_files_p;
+  for (int i = 0; i < numReached; ++i) {
+    memcpy(f, scc->members(reached[i]),
+           scc->numMembers(reached[i]) * sizeof *f);
+    f += scc->numMembers(reached[i]);
+  }
+  std::sort(d_files_p, d_files_p + d_numFiles);
+  delete [] reached;
+}
+
+HeaderFileIteratorImpl::~HeaderFileIteratorImpl() {
+  delete [] d_files_p;
 }
 
                 // -*-*-*- HeaderFileIterator -*-*-*-
 
 HeaderFileIterator::HeaderFileIterator(const RootFileIterator& iter)
     : impl_(new HeaderFileIteratorImpl(*iter.d_this)) {
-  ++*this;
 }
 
 HeaderFileIterator::~HeaderFileIterator() {
@@ -405,22 +877,15 @@ HeaderFileIterator::~HeaderFileIterator() {
 
 void HeaderFileIterator::operator++() {
   assert(*this);
-  idep::BinaryRelation* rel = impl_->d_iter.d_dep.d_dependencies_p;
-
-  do {
-    ++impl_->d_index;
-  } while (impl_->d_index < rel->Length() &&
-           !rel->get(impl_->d_iter.d_index, impl_->d_index)
-  );
+  ++impl_->d_index;
 }
 
 HeaderFileIterator::operator const void *() const {
-  idep::BinaryRelation* rel = impl_->d_iter.d_dep.d_dependencies_p;
-  return impl_->d_index < rel->Length() ? this : 0;
+  return impl_->d_index < impl_->d_numFiles ? this : 0;
 }
 
 const char* HeaderFileIterator::operator()() const {
-  return (*impl_->d_iter.d_dep.d_fileNames_p)[impl_->d_index];
+  return impl_->d_names[impl_->d_files_p[impl_->d_index]];
 }
 
 }  // namespace idep
@@ -7,6 +7,7 @@
 //   HeaderFileIterator: iterate over the dependencies of each root file
 
 #include "basictypes.h"
+#include "idep_file_loader.h"
 
 #include <ostream>
 
@@ -51,6 +52,34 @@ class CompileDep {
   // non-ascii characters.
   void InputRootFiles();
 
+  // Specify whether include directives that are commented out or in
+  // conditionally compiled sections ruled out by the macros given to
+  // DefineMacro and UndefineMacro are to be skipped.  By default, every
+  // include directive counts, wherever it appears.
+  void SetSkipInactiveIncludes(bool skip_flag);
+
+  // Define a macro for deciding which sections are inactive, as specified
+  // by a -D option: "NAME" or "NAME=VALUE".
+  void DefineMacro(const char* definition);
+
+  // Undefine the specified macro for deciding which sections are inactive,
+  // as a -U option does.
+  void UndefineMacro(const char* name);
+
+  // Specify the file in which to keep the include directives found in
+  // each file from one calculation to the next, so that a file need not
+  // be scanned again until it changes; 0 (the default) for none.  The
+  // cache file is read at the start of Calculate() and rewritten at the
+  // end if anything was added to it.
+  void SetCacheFile(const char* file_name);
+
+  // Specify whether all the files to be analyzed are to be loaded and
+  // scanned at once, many at a time, by the specified engine, before the
+  // dependencies are calculated.  By default, each file is read when it
+  // is first reached.  The results are the same either way.
+  void SetAsynchronousLoading(bool async_flag,
+                              FileLoader::Engine engine = FileLoader::AUTO);
+
   // Calculate compile-time dependencies among the specified set of
   // rootfiles. Return true on success, false on error.  Errors will
   // be printed to the indicated output stream (err).  By default,
@@ -62,6 +91,11 @@ class CompileDep {
   // provides an incomplete list of compile-time dependencies.
   bool Calculate(std::ostream& err, bool recursion_flag);
 
+  // Return the number of include directives skipped by the most recent
+  // calculation because they were inactive.  This is always 0 unless
+  // SetSkipInactiveIncludes(true) was called.
+  int NumSkippedIncludes() const;
+
  private:
   friend class RootFileIterator;
   friend class HeaderFileIterator;
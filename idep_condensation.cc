@@ -0,0 +1,513 @@
+#include "idep_condensation.h"
+
+#include <assert.h>
+#include <memory.h>
+
+#include <algorithm>
+
+#include "idep_row_kernel.h"
+#include "idep_sparse_relation.h"
+#include "idep_thread_team.h"
+
+// IMPLEMENTATION NOTE: CLOSURE ROWS
+// The closure of each strong component is computed once, in reverse
+// topological order, as the union of its direct successors and of their
+// (already final) closures.  A successor that is already in the union was
+// reached by way of another, and so is everything it reaches, so it is
+// skipped; successors are taken from the highest number down so that
+// this happens as often as possible.
+//
+// A closure of k components is stored in k ints as a sorted list, or in
+// W = ceil(Length() / 64) words as a row of bits, whichever is smaller
+// (i.e., as bits if and only if k > 2 * W).  A list is gathered in a
+// scratch row of bits that remembers which bits it set, so that building
+// and clearing it costs O(k) rather than O(W); once any successor has a
+// row of bits, the result is a row of bits too, and is built directly by
+// word-parallel unions.
+//
+// Rows are carved out of large chunks owned by the condensation, one
+// pool per thread, so that a million small closures need not be a
+// million allocations.
+
+typedef idep::RowKernel::Word Word;
+
+enum { BITS_PER_WORD = 64 };
+
+// Number of words in each chunk of a RowPool, unless a larger row needs
+// a chunk of its own.
+enum { POOL_CHUNK_WORDS = 1 << 16 };
+
+// Relations with fewer components than this are always closed by the
+// calling thread alone, as starting a team of threads would cost more
+// than it saves.
+enum { PARALLEL_MIN_LENGTH = 512 };
+
+// Number of threads used to compute closures (0 means one per processor);
+// see Condensation::setNumThreads.
+static int s_numThreads = 1;
+
+static int threadsFor(int length) {
+    if (length < PARALLEL_MIN_LENGTH) {
+        return 1;
+    }
+    return s_numThreads > 0 ? s_numThreads
+                            : idep::ThreadTeam::HardwareThreads();
+}
+
+static inline int testBit(const Word *row, int col) {
+    return (row[col / BITS_PER_WORD] >> (col % BITS_PER_WORD)) & 1;
+}
+
+static inline void setBit(Word *row, int col) {
+    row[col / BITS_PER_WORD] |= Word(1) << (col % BITS_PER_WORD);
+}
+
+                // -*-*-*- RowPool -*-*-*-
+
+class RowPool {
+    // Hand out blocks of words carved from large chunks, which are all
+    // freed together when the pool is destroyed.
+
+    Word **d_chunks_p;      // every chunk allocated so far
+    int d_numChunks;        // number of chunks in d_chunks_p
+    int d_chunksSize;       // physical size of d_chunks_p
+    Word *d_next_p;         // next free word of the current chunk
+    int d_left;             // number of free words in the current chunk
+
+  public:
+    RowPool();
+    ~RowPool();
+
+    Word *allocate(int words);
+    // Return a block of the specified number of (uninitialized) words.
+};
+
+RowPool::RowPool()
+    : d_chunks_p(0),
+      d_numChunks(0),
+      d_chunksSize(0),
+      d_next_p(0),
+      d_left(0) {
+}
+
+RowPool::~RowPool() {
+    for (int i = 0; i < d_numChunks; ++i) {
+        delete [] d_chunks_p[i];
+    }
+    delete [] d_chunks_p;
+}
+
+Word *RowPool::allocate(int words) {
+    if (words > d_left) {
+        if (d_numChunks >= d_chunksSize) {
+            const int size = d_chunksSize > 0 ? d_chunksSize * 2 : 16;
+            Word **chunks = new Word *[size];
+            if (d_numChunks) {
+                memcpy(chunks, d_chunks_p, d_numChunks * sizeof *chunks);
+            }
+            delete [] d_chunks_p;
+            d_chunks_p = chunks;
+            d_chunksSize = size;
+        }
+        const int size = words > POOL_CHUNK_WORDS ? words : POOL_CHUNK_WORDS;
+        d_next_p = d_chunks_p[d_numChunks++] = new Word[size];
+        d_left = size;
+    }
+    Word *block = d_next_p;
+    d_next_p += words;
+    d_left -= words;
+    return block;
+}
+
+namespace idep {
+
+                // -*-*-*- CondensationImpl -*-*-*-
+
+struct CondensationImpl {
+    int d_numEntries;           // length of the condensed relation
+    int d_length;               // number of strong components
+    int *d_components_p;        // strong component of each entry
+    int *d_start_p;             // start of each component in d_members_p
+    int *d_members_p;           // entries grouped by component
+    char *d_cyclic_p;           // whether each component reaches itself
+    SparseRelation *d_dag_p;    // direct dependencies among components
+    const Word **d_rows_p;      // closure of each component: list or bits
+    int *d_numReached_p;        // number of components in each closure
+    int d_words;                // number of words in a row of bits
+    RowPool *d_pools_p;         // storage of the closures, one per thread
+    int d_numPools;             // number of pools in d_pools_p
+
+    CondensationImpl();
+    ~CondensationImpl();
+
+    int isDense(int c) const;
+    // Return 1 if the closure of the specified component is stored as a
+    // row of bits, and 0 if it is stored as a sorted list.
+
+    void close(int c, Word *scratch, int *touched, RowPool *pool);
+    // Compute the closure of the specified component, whose successors
+    // must already be closed, in the specified zeroed scratch row (which
+    // is left zeroed) and list of Length() ints, storing it in the
+    // specified pool.
+
+    void closeAll();
+    // Compute the closure of every component, using as many threads as
+    // set by Condensation::setNumThreads.
+};
+
+CondensationImpl::CondensationImpl()
+    : d_numEntries(0),
+      d_length(0),
+      d_components_p(0),
+      d_start_p(0),
+      d_members_p(0),
+      d_cyclic_p(0),
+      d_dag_p(0),
+      d_rows_p(0),
+      d_numReached_p(0),
+      d_words(0),
+      d_pools_p(0),
+      d_numPools(0) {
+}
+
+CondensationImpl::~CondensationImpl() {
+    delete [] d_components_p;
+    delete [] d_start_p;
+    delete [] d_members_p;
+    delete [] d_cyclic_p;
+    delete d_dag_p;
+    delete [] d_rows_p;
+    delete [] d_numReached_p;
+    delete [] d_pools_p;
+}
+
+inline int CondensationImpl::isDense(int c) const {
+    return d_numReached_p[c] > 2 * d_words;
+}
+
+void CondensationImpl::close(int c, Word *scratch, int *touched,
+                             RowPool *pool) {
+    const int w = d_words;
+    const int *succ = d_dag_p->successors(c);
+    const int numSucc = d_dag_p->numSuccessors(c);
+
+    int dense = 0;
+    for (int k = 0; k < numSucc; ++k) {
+        if (isDense(succ[k])) {
+            dense = 1;
+            break;
+        }
+    }
+
+    if (dense) {
+        Word *row = pool->allocate(w);
+        memset(row, 0, w * sizeof *row);
+        for (int k = numSucc - 1; k >= 0; --k) {
+            const int t = succ[k];
+            if (testBit(row, t)) {
+                continue;               // t and its closure already reached
+            }
+            setBit(row, t);
+            if (isDense(t)) {
+                RowKernel::Or(row, d_rows_p[t], w);
+            }
+            else {
+                const int *list = reinterpret_cast<const int *>(d_rows_p[t]);
+                for (int i = d_numReached_p[t]; i > 0; --i) {
+                    setBit(row, *list++);
+                }
+            }
+        }
+        if (d_cyclic_p[c]) {
+            setBit(row, c);
+        }
+        int count = 0;
+        for (int i = 0; i < w; ++i) {
+            count += __builtin_popcountll(row[i]);
+        }
+        d_rows_p[c] = row;
+        d_numReached_p[c] = count;
+        return;
+    }
+
+    int count = 0;
+    for (int k = numSucc - 1; k >= 0; --k) {
+        const int t = succ[k];
+        if (testBit(scratch, t)) {
+            continue;                   // t and its closure already reached
+        }
+        setBit(scratch, t);
+        touched[count++] = t;
+        const int *list = reinterpret_cast<const int *>(d_rows_p[t]);
+        for (int i = d_numReached_p[t]; i > 0; --i) {
+            const int u = *list++;
+            if (!testBit(scratch, u)) {
+                setBit(scratch, u);
+                touched[count++] = u;
+            }
+        }
+    }
+    if (d_cyclic_p[c]) {
+        setBit(scratch, c);
+        touched[count++] = c;
+    }
+
+    if (count > 2 * w) {
+        Word *row = pool->allocate(w);
+        memcpy(row, scratch, w * sizeof *row);
+        d_rows_p[c] = row;
+    }
+    else if (count) {
+        std::sort(touched, touched + count);
+        int *list = reinterpret_cast<int *>(pool->allocate((count + 1) / 2));
+        memcpy(list, touched, count * sizeof *list);
+        d_rows_p[c] = reinterpret_cast<const Word *>(list);
+    }
+    else {
+        d_rows_p[c] = 0;                // reaches nothing
+    }
+    d_numReached_p[c] = count;
+
+    for (int i = 0; i < count; ++i) {
+        scratch[touched[i] / BITS_PER_WORD] = 0;
+    }
+}
+
+struct ClosureJob {
+    ThreadTeam *team;
+    CondensationImpl *impl;
+    const int *byLevel;      // components in order of level
+    const int *levelStart;   // start of each level in byLevel
+    int *next;               // next unclaimed component of each level
+    int numLevels;
+};
+
+static void runClosure(void *arg, int thread, int) {
+    // The components of each level are claimed one at a time by whichever
+    // thread is free, as their costs vary widely.
+    const ClosureJob *job = static_cast<ClosureJob *>(arg);
+    CondensationImpl *impl = job->impl;
+    const int w = impl->d_words;
+    Word *scratch = new Word[w > 0 ? w : 1];
+    int *touched = new int[impl->d_length > 0 ? impl->d_length : 1];
+    memset(scratch, 0, w * sizeof *scratch);
+    for (int l = 0; l < job->numLevels; ++l) {
+        for (;;) {
+            const int i = __sync_fetch_and_add(&job->next[l], 1);
+            if (i >= job->levelStart[l + 1]) {
+                break;
+            }
+            impl->close(job->byLevel[i], scratch, touched,
+                        &impl->d_pools_p[thread]);
+        }
+        job->team->Barrier();
+    }
+    delete [] touched;
+    delete [] scratch;
+}
+
+void CondensationImpl::closeAll() {
+    const int n = d_length;
+    const int w = d_words;
+    const int numThreads = threadsFor(n);
+
+    d_rows_p = new const Word *[n > 0 ? n : 1];
+    d_numReached_p = new int[n > 0 ? n : 1];
+    d_pools_p = new RowPool[numThreads];
+    d_numPools = numThreads;
+
+    if (numThreads <= 1) {
+        Word *scratch = new Word[w > 0 ? w : 1];
+        int *touched = new int[n > 0 ? n : 1];
+        memset(scratch, 0, w * sizeof *scratch);
+        for (int c = 0; c < n; ++c) {
+            close(c, scratch, touched, d_pools_p);
+        }
+        delete [] touched;
+        delete [] scratch;
+        return;
+    }
+
+    // The level of a component is one more than the highest level of any
+    // component it reaches directly; those all come earlier.  The
+    // components of one level are independent of one another.
+    int *level = new int[n];
+    int numLevels = 0;
+    for (int c = 0; c < n; ++c) {
+        int l = 0;
+        const int *succ = d_dag_p->successors(c);
+        for (int k = d_dag_p->numSuccessors(c); k > 0; --k) {
+            const int t = *succ++;
+            if (level[t] >= l) {
+                l = level[t] + 1;
+            }
+        }
+        level[c] = l;
+        if (l >= numLevels) {
+            numLevels = l + 1;
+        }
+    }
+
+    // Order the components by level (counting sort).
+    int *levelStart = new int[numLevels + 1];
+    int *byLevel = new int[n];
+    memset(levelStart, 0, (numLevels + 1) * sizeof *levelStart);
+    for (int c = 0; c < n; ++c) {
+        ++levelStart[level[c] + 1];
+    }
+    for (int l = 0; l < numLevels; ++l) {
+        levelStart[l + 1] += levelStart[l];
+    }
+    int *next = new int[numLevels];
+    memcpy(next, levelStart, numLevels * sizeof *next);
+    for (int c = 0; c < n; ++c) {
+        byLevel[next[level[c]]++] = c;
+    }
+    memcpy(next, levelStart, numLevels * sizeof *next);
+
+    ClosureJob job = { 0, this, byLevel, levelStart, next, numLevels };
+    ThreadTeam team(numThreads);
+    job.team = &team;
+    RowKernel::Current();           // resolve the kernel before starting
+    team.Run(runClosure, &job);
+
+    delete [] next;
+    delete [] byLevel;
+    delete [] levelStart;
+    delete [] level;
+}
+
+                // -*-*-*- Condensation -*-*-*-
+
+Condensation::Condensation(const SparseRelation& relation)
+    : impl_(new CondensationImpl) {
+    assert(relation.isFrozen());
+
+    const int s = relation.Length();
+    impl_->d_numEntries = s;
+    impl_->d_components_p = new int[s > 0 ? s : 1];
+    const int n = relation.strongComponents(impl_->d_components_p);
+    const int *components = impl_->d_components_p;
+    impl_->d_length = n;
+    impl_->d_words = (n + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    // Group the members of each component together (counting sort).
+    int *start = impl_->d_start_p = new int[n + 1];
+    int *members = impl_->d_members_p = new int[s > 0 ? s : 1];
+    memset(start, 0, (n + 1) * sizeof *start);
+    for (int i = 0; i < s; ++i) {
+        ++start[components[i] + 1];
+    }
+    for (int c = 0; c < n; ++c) {
+        start[c + 1] += start[c];
+    }
+    for (int i = 0; i < s; ++i) {
+        members[start[components[i]]++] = i;
+    }
+    for (int c = n; c > 0; --c) {
+        start[c] = start[c - 1];
+    }
+    start[0] = 0;
+
+    // Collect the edges between distinct components; an edge within a
+    // component only shows that the component reaches itself.
+    impl_->d_cyclic_p = new char[n > 0 ? n : 1];
+    for (int c = 0; c < n; ++c) {
+        impl_->d_cyclic_p[c] = start[c + 1] - start[c] > 1;
+    }
+    impl_->d_dag_p = new SparseRelation(n, relation.numEdges());
+    for (int u = 0; u < s; ++u) {
+        const int cu = components[u];
+        const int *p = relation.successors(u);
+        for (int k = relation.numSuccessors(u); k > 0; --k) {
+            const int cv = components[*p++];
+            if (cv != cu) {
+                impl_->d_dag_p->set(cu, cv);
+            }
+            else {
+                impl_->d_cyclic_p[cu] = 1;
+            }
+        }
+    }
+    impl_->d_dag_p->freeze();
+
+    impl_->closeAll();
+}
+
+Condensation::~Condensation() {
+    delete impl_;
+}
+
+int Condensation::Length() const {
+    return impl_->d_length;
+}
+
+int Condensation::numEntries() const {
+    return impl_->d_numEntries;
+}
+
+int Condensation::component(int entry) const {
+    return impl_->d_components_p[entry];
+}
+
+int Condensation::numMembers(int component) const {
+    return impl_->d_start_p[component + 1] - impl_->d_start_p[component];
+}
+
+const int *Condensation::members(int component) const {
+    return impl_->d_members_p + impl_->d_start_p[component];
+}
+
+int Condensation::isCyclic(int component) const {
+    return impl_->d_cyclic_p[component];
+}
+
+int Condensation::numSuccessors(int component) const {
+    return impl_->d_dag_p->numSuccessors(component);
+}
+
+const int *Condensation::successors(int component) const {
+    return impl_->d_dag_p->successors(component);
+}
+
+int Condensation::numReached(int component) const {
+    return impl_->d_numReached_p[component];
+}
+
+int Condensation::reached(int component, int *result) const {
+    const int count = impl_->d_numReached_p[component];
+    const Word *row = impl_->d_rows_p[component];
+    if (!impl_->isDense(component)) {
+        if (count) {
+            memcpy(result, row, count * sizeof *result);
+        }
+        return count;
+    }
+    int *r = result;
+    for (int i = 0; i < impl_->d_words; ++i) {
+        for (Word bits = row[i]; bits; bits &= bits - 1) {
+            *r++ = i * BITS_PER_WORD + __builtin_ctzll(bits);
+        }
+    }
+    assert(r - result == count);
+    return count;
+}
+
+int Condensation::reaches(int from, int to) const {
+    const Word *row = impl_->d_rows_p[from];
+    if (impl_->isDense(from)) {
+        return testBit(row, to);
+    }
+    const int *list = reinterpret_cast<const int *>(row);
+    return std::binary_search(list, list + impl_->d_numReached_p[from], to);
+}
+
+void Condensation::setNumThreads(int numThreads) {
+    s_numThreads = numThreads > 0 ? numThreads : 0;
+}
+
+int Condensation::numThreads() {
+    return s_numThreads;
+}
+
+}  // namespace idep
@@ -0,0 +1,92 @@
+#ifndef IDEP_CONDENSATION_H_
+#define IDEP_CONDENSATION_H_
+
+#include "basictypes.h"
+
+namespace idep {
+
+class SparseRelation;
+
+struct CondensationImpl;
+
+// This component defines 1 fully insulated class:
+// The DAG of the strong components of a sparse relation, together with
+// its transitive closure.
+//
+// Every entry of a strong component reaches exactly the same entries, so
+// the closure is kept once per component, as the set of components it
+// reaches.  Each such set is stored either as a sorted list of component
+// indices or as a row of bits, whichever is smaller, so that memory is
+// proportional to the size of the closure for a sparse graph and never
+// exceeds that of a dense matrix over the components.  Nothing the size
+// of the square of the number of entries is ever allocated.
+class Condensation {
+ public:
+  // Condense the specified relation, which must be frozen, and compute
+  // the transitive closure of the result.  Strong components are numbered
+  // exactly as by SparseRelation::strongComponents: in reverse
+  // topological order.
+  explicit Condensation(const SparseRelation& relation);
+  ~Condensation();
+
+  // Return the number of strong components.
+  int Length() const;
+
+  // Return the number of entries of the condensed relation.
+  int numEntries() const;
+
+  // Return the strong component of the specified entry.
+  int component(int entry) const;
+
+  // Return the number of entries in the specified component.
+  int numMembers(int component) const;
+
+  // Return the entries of the specified component, in increasing order;
+  // the array holds numMembers(component) values.
+  const int *members(int component) const;
+
+  // Return 1 if the specified component reaches itself (i.e., it has more
+  // than one member, or an entry that is related to itself); else 0.
+  int isCyclic(int component) const;
+
+  // Return the number of components on which the specified component
+  // depends directly, not counting itself.
+  int numSuccessors(int component) const;
+
+  // Return the components on which the specified component depends
+  // directly, not counting itself, in increasing order; the array holds
+  // numSuccessors(component) values.
+  const int *successors(int component) const;
+
+  // Return the number of components reachable from the specified
+  // component by a path of one or more steps (including the component
+  // itself if and only if it is cyclic).
+  int numReached(int component) const;
+
+  // Load into the specified array, which must have room for
+  // numReached(component) values, the components reachable from the
+  // specified component, in increasing order.  Return their number.
+  int reached(int component, int *result) const;
+
+  // Return 1 if the second specified component is reachable from the
+  // first; else 0.
+  int reaches(int from, int to) const;
+
+  // Set the number of threads among which the closure of every
+  // subsequently created condensation is divided.  By default only the
+  // calling thread is used; 0 selects one thread per processor.  The
+  // result does not depend on the number of threads.
+  static void setNumThreads(int numThreads);
+
+  // Return the number of threads set by setNumThreads.
+  static int numThreads();
+
+ private:
+  CondensationImpl *impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(Condensation);
+};
+
+}  // namespace idep
+
+#endif  // IDEP_CONDENSATION_H_
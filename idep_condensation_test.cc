@@ -0,0 +1,108 @@
+// Check that the closure of a Condensation agrees with that computed by
+// Warshall's algorithm on the dense relation, for one thread and for
+// several, on random relations with fewer and more components than are
+// needed to divide the closure among threads.  Exit with the number of
+// mismatches found.
+
+#include "idep_binary_relation.h"
+#include "idep_condensation.h"
+#include "idep_sparse_relation.h"
+
+#include <stdio.h>
+
+namespace {
+
+using idep::BinaryRelation;
+using idep::Condensation;
+using idep::SparseRelation;
+
+// Return the next value of a small linear congruential generator, so
+// that the relations, and any mismatch reported, are the same everywhere.
+unsigned Random(unsigned *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+// Return 1 if the specified condensation of a relation agrees with the
+// specified closure of the same relation, and 0 otherwise.
+int Agrees(const Condensation& condensation, const BinaryRelation& closed) {
+    const int length = closed.Length();
+    if (condensation.numEntries() != length) {
+        return 0;
+    }
+    int *reached = new int[condensation.Length() + 1];
+    int ok = 1;
+    for (int c = 0; ok && c < condensation.Length(); ++c) {
+        const int n = condensation.reached(c, reached);
+        ok = n == condensation.numReached(c);
+        for (int k = 1; ok && k < n; ++k) {
+            ok = reached[k - 1] < reached[k];
+        }
+    }
+    for (int i = 0; ok && i < length; ++i) {
+        const int ci = condensation.component(i);
+        for (int j = 0; ok && j < length; ++j) {
+            ok = closed.get(i, j) == condensation.reaches(ci,
+                                                condensation.component(j));
+        }
+    }
+    delete [] reached;
+    return ok;
+}
+
+}  // namespace
+
+int main() {
+    const int sizes[] = {
+        0, 1, 2, 63, 64, 65, 511, 512, 513, 1000, 2000
+    };
+    const int numSizes = sizeof sizes / sizeof *sizes;
+
+    // Edges per entry: below, around and above the threshold at which a
+    // random relation gains a giant strong component.
+    const double densities[] = { 0.5, 1.0, 2.0, 8.0 };
+    const int numDensities = sizeof densities / sizeof *densities;
+
+    const int threads[] = { 1, 4 };
+    const int numThreads = sizeof threads / sizeof *threads;
+
+    int failures = 0;
+    int cases = 0;
+    for (int s = 0; s < numSizes; ++s) {
+        for (int d = 0; d < numDensities; ++d) {
+            const int length = sizes[s];
+            const int edges = int(densities[d] * length);
+
+            SparseRelation relation(length, edges);
+            BinaryRelation closed(length);
+            unsigned state = 7919u * length + d;
+            for (int e = 0; length && e < edges; ++e) {
+                int row = Random(&state) % length;
+                int col = Random(&state) % length;
+                relation.set(row, col);
+                closed.set(row, col);
+            }
+            relation.freeze();
+            closed.makeTransitive(BinaryRelation::WARSHALL);
+
+            for (int t = 0; t < numThreads; ++t) {
+                Condensation::setNumThreads(threads[t]);
+                Condensation condensation(relation);
+                ++cases;
+                if (!Agrees(condensation, closed)) {
+                    printf("FAIL: closure differs from WARSHALL "
+                           "(length %d, %d edges, %d components, "
+                           "%d thread%s)\n",
+                           length, edges, condensation.Length(),
+                           threads[t], threads[t] == 1 ? "" : "s");
+                    ++failures;
+                }
+            }
+        }
+    }
+    Condensation::setNumThreads(1);
+
+    printf("%d of %d closures agree with WARSHALL.\n",
+           cases - failures, cases);
+    return failures;
+}
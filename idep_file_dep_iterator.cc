@@ -1,53 +1,286 @@
 #include "idep_file_dep_iterator.h"
 
 #include <assert.h>
-#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>      // open()
 #include <memory.h>
+#include <stdlib.h>     // strtol()
 #include <string.h>
+#include <sys/mman.h>   // mmap() munmap()
+#include <sys/stat.h>   // fstat()
+#include <unistd.h>     // read() close()
+
+#include <string>
+
+#include "idep_char_scan.h"
+#include "idep_macro_table.h"
+
+// IMPLEMENTATION NOTE: The whole file is brought into memory when the
+// iterator is created: it is mapped privately and writably (so that a
+// write affects only a copy of the page concerned), or, if it cannot be
+// mapped (e.g., it is empty or a pipe), read into an array with read().
+// The file descriptor is closed right away, so iterators that are alive
+// at once (as in CompileDep's recursive getDep()) hold no descriptors.
+//
+// Only lines whose first non-blank character is '#' are looked at:
+// CharScan finds each '#' in the file many characters at a time, and
+// those preceded on their line by anything but spaces and tabs are
+// skipped.  An include name is returned in place, terminated by
+// overwriting the character that ends it ('>', '"' or white space); a
+// '\0' found there later (after Reset()) ends the name as well.  A name
+// that runs to the end of its line is copied instead, since overwriting
+// the newline would join the next line to this one.
+//
+// Given a macro table, the iterator instead looks at every character
+// outside of comments, so that it knows at each '#' whether it is in a
+// literal; a comment is passed over in one step by looking for its end.
+// A directive is recognized by the same rule in both modes.  The open conditional sections are kept
+// in the iterator, so that the file is still scanned just once.  An
+// include directive that is commented out, i.e., is preceded on its line
+// only by white space, '/' and '*', counts as skipped.  Conditions are
+// evaluated in three-valued logic: a section is inactive only if its
+// condition is known to be false, or an earlier branch of the same #if
+// is known to be taken.
+
+enum { READ_SIZE = 1 << 16 };           // initial size for unsized files
+enum { START_DEPTH = 8, GROW_FACTOR = 2 };
+enum { MAX_NUMBER_LENGTH = 32 };
+
+namespace {
+
+enum Truth { IS_FALSE, IS_TRUE, IS_UNKNOWN };
+
+inline bool isIdentifierChar(char c) {
+  return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+         ('0' <= c && c <= '9') || '_' == c;
+}
+
+Truth numberTruth(const char* number) {
+  // Return whether the specified integer constant is non-zero, or
+  // IS_UNKNOWN if it is not (just) an integer constant.
+  char* end;
+  const long value = strtol(number, &end, 0);
+  while ('u' == *end || 'U' == *end || 'l' == *end || 'L' == *end)
+    ++end;
+  while (idep::CharScan::IsSpace(*end))
+    ++end;
+  return end == number || *end ? IS_UNKNOWN : value ? IS_TRUE : IS_FALSE;
+}
 
-#include <fstream>
+// Recursive-descent evaluator for the condition of an #if or #elif
+// directive, limited to integer constants, macros, defined, !, &&, ||
+// and parentheses; anything else makes the whole condition IS_UNKNOWN.
+class ConditionParser {
+ public:
+  ConditionParser(const idep::MacroTable& macros,
+                  const char* begin,
+                  const char* end)
+      : macros_(macros), p_(begin), end_(end), failed_(false) {
+  }
 
-// Arbitrary maximum length for line containing an include directive. Note that
-// other lines may be longer.
-enum { MAX_LINE_LENGTH  = 2048 };
+  // Return the value of the whole condition.
+  Truth Parse() {
+    const Truth t = ParseOr();
+    SkipBlanks();
+    return failed_ || p_ != end_ ? IS_UNKNOWN : t;
+  }
 
-static int loadBuf(std::istream& in, char* buf, int bufSize) {
-    enum { END_OF_INPUT = -1, SUCCESS = 0, OVERFLOW = 1 };
+ private:
+  void SkipBlanks() {
+    for (;;) {
+      while (p_ < end_ && idep::CharScan::IsSpace(*p_))
+        ++p_;
+      if (end_ - p_ < 2 || '/' != *p_ || ('/' != p_[1] && '*' != p_[1]))
+        return;
+      if ('/' == p_[1]) {
+        end_ = p_;                      // comment to end of line
+        return;
+      }
+      const char* q = p_ + 2;
+      while (q + 1 < end_ && ('*' != *q || '/' != q[1]))
+        ++q;
+      if (q + 1 >= end_) {
+        end_ = p_;                      // comment continues past the line
+        return;
+      }
+      p_ = q + 2;
+    }
+  }
 
-    // The getline (istream) method returns the line as a string but extracts
-    // the trailing '\n'  only if there is space to spare in the buffer.  We
-    // need to test for this condition by placing a non-null character in the 
-    // last position of the array before loading it.  If the last character is 
-    // null after the read then the newline was NOT extracted.
+  bool Accept(const char* token) {
+    SkipBlanks();
+    const int length = strlen(token);
+    if (end_ - p_ < length || 0 != memcmp(p_, token, length))
+      return false;
+    p_ += length;
+    return true;
+  }
 
-    int nearEnd = bufSize - 1;
+  int Identifier() {
+    // Return the length of the identifier at p_, or 0 if there is none.
+    const char* q = p_;
+    while (q < end_ && isIdentifierChar(*q))
+      ++q;
+    return q - p_;
+  }
 
-    buf[nearEnd] = '\n'; // anything but '\0'
+  Truth ParseOr() {
+    Truth t = ParseAnd();
+    while (!failed_ && Accept("||")) {
+      const Truth u = ParseAnd();
+      t = IS_TRUE == t || IS_TRUE == u ? IS_TRUE
+        : IS_FALSE == t && IS_FALSE == u ? IS_FALSE : IS_UNKNOWN;
+    }
+    return t;
+  }
 
-    if (in.getline(buf, bufSize).fail()) {
-        return END_OF_INPUT;    // nothing left
+  Truth ParseAnd() {
+    Truth t = ParseUnary();
+    while (!failed_ && Accept("&&")) {
+      const Truth u = ParseUnary();
+      t = IS_FALSE == t || IS_FALSE == u ? IS_FALSE
+        : IS_TRUE == t && IS_TRUE == u ? IS_TRUE : IS_UNKNOWN;
     }
+    return t;
+  }
 
-    if ('\0' == buf[nearEnd]) { // line was too long
-        char c;
-        while (in && !in.get(c).eof() && c != '\n') { 
-            // skip to next line
-        }
-        return OVERFLOW;        // buffer contains null-terminated string
+  Truth ParseUnary() {
+    if (Accept("!") && !(p_ < end_ && '=' == *p_)) {
+      const Truth t = ParseUnary();
+      return IS_UNKNOWN == t ? t : IS_TRUE == t ? IS_FALSE : IS_TRUE;
+    }
+    if (Accept("(")) {
+      const Truth t = ParseOr();
+      if (!Accept(")"))
+        failed_ = true;
+      return t;
+    }
+    return ParsePrimary();
+  }
+
+  Truth ParsePrimary() {
+    SkipBlanks();
+    const int length = Identifier();
+    if (0 == length) {
+      failed_ = true;
+      return IS_UNKNOWN;
+    }
+
+    if ('0' <= *p_ && *p_ <= '9') {     // integer constant
+      if (length >= MAX_NUMBER_LENGTH) {
+        failed_ = true;
+        return IS_UNKNOWN;
+      }
+      char number[MAX_NUMBER_LENGTH];
+      memcpy(number, p_, length);
+      number[length] = '\0';
+      p_ += length;
+      const Truth t = numberTruth(number);
+      failed_ = IS_UNKNOWN == t;
+      return t;
+    }
+
+    if (7 == length && 0 == memcmp(p_, "defined", length)) {
+      p_ += length;
+      const bool paren = Accept("(");
+      SkipBlanks();
+      const char* name = p_;
+      const int nameLength = Identifier();
+      p_ += nameLength;
+      if (0 == nameLength || (paren && !Accept(")"))) {
+        failed_ = true;
+        return IS_UNKNOWN;
+      }
+      const char* value;
+      switch (macros_.Lookup(name, nameLength, &value)) {
+        case idep::MacroTable::DEFINED: return IS_TRUE;
+        case idep::MacroTable::UNDEFINED: return IS_FALSE;
+        default: return IS_UNKNOWN;
+      }
+    }
+
+    const char* name = p_;
+    p_ += length;
+    if (p_ < end_ && '(' == *p_) {      // function-like macro
+      failed_ = true;
+      return IS_UNKNOWN;
+    }
+    const char* value;
+    switch (macros_.Lookup(name, length, &value)) {
+      case idep::MacroTable::DEFINED: return numberTruth(value);
+      case idep::MacroTable::UNDEFINED: return IS_FALSE;  // counts as 0
+      default: break;
     }
+    if (4 == length && 0 == memcmp(name, "true", length))
+      return IS_TRUE;
+    if (5 == length && 0 == memcmp(name, "false", length))
+      return IS_FALSE;
+    return IS_UNKNOWN;
+  }
+
+  const idep::MacroTable& macros_;
+  const char* p_;               // next character to parse
+  const char* end_;             // end of the condition
+  bool failed_;                 // whether the condition is unsupported
+};
+
+bool isIncludeDirective(const char* hash, const char* end) {
+  // Return whether the specified '#' starts an include directive.
+  const char* p = idep::CharScan::SkipBlanks(hash + 1, end);
+  return end - p >= 7 && 0 == memcmp(p, "include", 7);
+}
+
+bool isLineStart(const char* data, const char* hash) {
+  // Return whether the specified '#' is preceded on its line only by
+  // spaces and tabs, and so may start a directive.
+  const char* p = hash;
+  while (p > data && (' ' == p[-1] || '\t' == p[-1]))
+    --p;
+  return p == data || '\n' == p[-1];
+}
 
-    return SUCCESS;
+bool isCommentedOut(const char* data, const char* hash) {
+  // Return whether the specified '#' is preceded on its line only by
+  // white space and comment markers.
+  const char* p = hash;
+  while (p > data && (' ' == p[-1] || '\t' == p[-1] ||
+                      '/' == p[-1] || '*' == p[-1]))
+    --p;
+  return p == data || '\n' == p[-1];
 }
 
-const char *extractDependency(char *buffer) {
-    // We assume we have a null terminated string that possibly contains a 
-    // valid include directive.  We will assume that such a directive has 
+const char* skipLiteral(const char* p, const char* end) {
+  // Return the end of the string or character literal starting at the
+  // specified position, or of its line if it is not terminated there.
+  const char quote = *p++;
+  while (p < end) {
+    if ('\\' == *p) {
+      p += 2;
+    } else if (quote == *p) {
+      return p + 1;
+    } else if ('\n' == *p) {
+      return p;
+    } else {
+      ++p;
+    }
+  }
+  return end;
+}
+
+}  // namespace
+
+static const char *extractDependency(const char *line,
+                                     const char *end,
+                                     int *length) {
+    // We assume that [line, end) is a line (without its newline, and
+    // from the first non-blank character on) that possibly contains a
+    // valid include directive.  We will assume that such a directive has
     // the following syntax:
     // 
-    // ^#[ \t]*"include"[ \t ]*[<"][ \t]*{filename}[>" \t\n]
-    //                                   ~~~~~~~~~~
-    // i.e.,                             ^want this
-    //  1. The first character on the line MUST be a '#'
+    // ^[ \t]*#[ \t]*"include"[ \t ]*[<"][ \t]*{filename}[>" \t\n]
+    //                                          ~~~~~~~~~~
+    // i.e.,                                    ^want this
+    //  1. The first non-blank character on the line MUST be a '#'
     //  2. This character may be followed by any number of spaces or tabs.
     //  3. The next non-whitespace char must be an 'i' followed by "nclude".
     //  4. This string may be followed by any number of spaces or tabs.
@@ -55,71 +288,391 @@ const char *extractDependency(char *buffer) {
     //  6. This character may be followed by any number of spaces or tabs.
     //  7. The {filename} follows and is terminated by whitespace, '>', or '"'.
     //
-    // If an include directive is found, the buffer is modified and a pointer 
-    // to the included filename is returned; otherwise 0 is returned. 
+    // If an include directive is found, a pointer to the included filename
+    // is returned and its length loaded into the specified location;
+    // otherwise 0 is returned. 
 
-    if ('#' != buffer[0]) {                             // 1.
+    if (line == end || '#' != line[0]) {                // 1.
         return 0;
     }
 
-    char *p = buffer;           
-    while (isspace(*++p)) {                             // 2.
+    const char *p = line + 1;
+    while (p < end && idep::CharScan::IsSpace(*p)) {    // 2.
+        ++p;
     }                           
 
-    if ('i' != *p) {                                    // 3a.
-        return 0;
-    }
-
-    static char KEY[] = "include";
-    if (0 != strncmp(p, "include", sizeof KEY - 1)) {   // 3b.
+    static const char KEY[] = "include";
+    enum { KEY_LENGTH = sizeof KEY - 1 };
+    if (end - p < KEY_LENGTH || 0 != memcmp(p, KEY, KEY_LENGTH)) { // 3.
         return 0;
     }
-    p += sizeof KEY - 1;        // advance over KEY
+    p += KEY_LENGTH;            // advance over KEY
 
-    while (isspace(*p)) {                               // 4.
+    while (p < end && idep::CharScan::IsSpace(*p)) {    // 4.
         ++p;
     }                           
 
-    if ('<' != *p && '"' != *p) {                       // 5.
+    if (p == end || ('<' != *p && '"' != *p)) {         // 5.
         return 0;
     }
     ++p;                        
 
-    while (isspace(*p)) {                               // 6.
+    while (p < end && idep::CharScan::IsSpace(*p)) {    // 6.
         ++p;
     }                           
 
     // At this point, p points to the start of the file name
     // all we need to do is detect the end of the string. 
 
-    int length = strcspn(p, " \t\">"); 
-    p[length] = 0;                                      // 7.
+    const char *q = p;
+    while (q < end && ' ' != *q && '\t' != *q && '"' != *q && '>' != *q &&
+           '\0' != *q) {
+        ++q;
+    }
+    *length = q - p;                                    // 7.
 
     return p;
 }
 
 namespace idep {
 
+// The state of one #if (or #ifdef or #ifndef) section whose #endif has
+// not been reached yet.
+struct ConditionalState {
+  bool d_outerDead;             // whether the enclosing section is inactive
+  bool d_taken;                 // whether a branch is known to be taken
+  bool d_dead;                  // whether the current branch is inactive
+};
+
 struct FileDepIteratorImpl {
-  std::ifstream d_file;
-  char d_buf[MAX_LINE_LENGTH];
+  char *d_data_p;               // contents of the file, or 0 if none
+  size_t d_size;                // number of characters in d_data_p
+  bool d_mapped;                // whether d_data_p is mapped or new[]'d
+  const char *d_next_p;         // first character not yet scanned
+  std::string d_name;           // current name, if it could not be
+                                // terminated in place
   const char *d_header_p;
   bool is_valid_file;
 
-  FileDepIteratorImpl(const char* file_name);
+  const MacroTable *d_macros_p;         // 0 unless skipping dead includes
+  ConditionalState *d_conditionals_p;   // open sections, innermost last
+  int d_depth;                          // number of open sections
+  int d_conditionalSize;                // physical size of the above
+  int d_numSkipped;
+
+  FileDepIteratorImpl(const char* file_name, const MacroTable *macros);
+  FileDepIteratorImpl(char *contents,
+                      size_t length,
+                      const MacroTable *macros);
+  ~FileDepIteratorImpl();
+
+  // Load the entire contents of the specified open file into d_data_p.
+  void load(int fd);
+
+  // Make the specified name, ending within the line ending at the
+  // specified position, the current header.
+  void setHeader(char *name, int length, const char *lineEnd);
+
+  // Advance d_next_p to just past the next include directive, or to the
+  // end of the file, following comments and conditional sections.
+  void scan();
+
+  // Count the include directives commented out in [begin, end) as
+  // skipped.
+  void countCommentedOut(const char *begin, const char *end);
+
+  // Process the directive whose '#' is at the specified position, and
+  // return the position from which to continue scanning.
+  const char *directive(const char *hash, const char *end);
+
+  // Return whether the current section is inactive.
+  bool dead() const {
+    return d_depth > 0 && d_conditionals_p[d_depth - 1].d_dead;
+  }
+
+  // Return the value of the condition in [begin, end).
+  Truth evaluate(const char *begin, const char *end) const;
+
+  // Open a section having a condition of the specified value.
+  void openSection(Truth condition);
+
+  // Begin a branch of the innermost section having a condition of the
+  // specified value (#elif), or none (#else).
+  void nextBranch(Truth condition);
+  void elseBranch();
+
+  // Close the innermost section (#endif).
+  void closeSection();
 };
 
-FileDepIteratorImpl::FileDepIteratorImpl(const char* file_name)
-    : d_file(file_name),
-      d_header_p(d_buf)  /* Buffer is not yet initialized. */,
-      is_valid_file(d_file != NULL) /* Depends on result of initialization. */ {
+FileDepIteratorImpl::FileDepIteratorImpl(const char* file_name,
+                                         const MacroTable *macros)
+    : d_data_p(0),
+      d_size(0),
+      d_mapped(false),
+      d_next_p(0),
+      d_header_p(0),
+      is_valid_file(false),
+      d_macros_p(macros),
+      d_conditionals_p(0),
+      d_depth(0),
+      d_conditionalSize(0),
+      d_numSkipped(0) {
+  const int fd = open(file_name, O_RDONLY);
+  if (fd >= 0) {
+    is_valid_file = true;
+    load(fd);
+    close(fd);
+  }
+  d_next_p = d_data_p;
 }
 
-FileDepIterator::FileDepIterator(const char *fileName)
-    : impl_(new FileDepIteratorImpl(fileName)) {
-  if (!IsValidFile())
-    impl_->d_header_p = 0; // Iteration state is invalid.
+FileDepIteratorImpl::FileDepIteratorImpl(char *contents,
+                                         size_t length,
+                                         const MacroTable *macros)
+    : d_data_p(contents),
+      d_size(length),
+      d_mapped(false),
+      d_next_p(contents),
+      d_header_p(0),
+      is_valid_file(true),
+      d_macros_p(macros),
+      d_conditionals_p(0),
+      d_depth(0),
+      d_conditionalSize(0),
+      d_numSkipped(0) {
+}
+
+FileDepIteratorImpl::~FileDepIteratorImpl() {
+  if (d_mapped)
+    munmap(d_data_p, d_size);
+  else
+    delete[] d_data_p;
+  delete[] d_conditionals_p;
+}
 
+void FileDepIteratorImpl::load(int fd) {
+  struct stat status;
+  const bool sized = 0 == fstat(fd, &status) && S_ISREG(status.st_mode) &&
+                     status.st_size > 0;
+  if (sized) {
+    void *map = mmap(0, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                     fd, 0);
+    if (MAP_FAILED != map) {
+      d_data_p = static_cast<char *>(map);
+      d_size = status.st_size;
+      d_mapped = true;
+      return;
+    }
+  }
+
+  size_t size = sized ? size_t(status.st_size) + 1  // one more to see end
+                     : size_t(READ_SIZE);
+  d_data_p = new char[size];
+  for (;;) {
+    const ssize_t n = read(fd, d_data_p + d_size, size - d_size);
+    if (n < 0 && EINTR == errno)
+      continue;                         // interrupted by a signal
+    if (n <= 0)
+      break;                            // end of file (or unreadable)
+    d_size += n;
+    if (d_size == size) {
+      char *tmp = d_data_p;
+      d_data_p = new char[size * 2];
+      memcpy(d_data_p, tmp, size);
+      size *= 2;
+      delete[] tmp;
+    }
+  }
+}
+
+void FileDepIteratorImpl::setHeader(char *name,
+                                    int length,
+                                    const char *lineEnd) {
+  if (name + length < lineEnd) {
+    name[length] = '\0';               // ends with '>', '"' or a space
+    d_header_p = name;
+  } else {
+    d_name.assign(name, length);
+    d_header_p = d_name.c_str();
+  }
+}
+
+void FileDepIteratorImpl::scan() {
+  const char *end = d_data_p + d_size;
+  const char *p = d_next_p;
+
+  d_header_p = 0;
+  while (p < end && !d_header_p) {
+    switch (*p) {
+      case '/': {
+        if (end - p > 1 && '*' == p[1]) {
+          const char *q = CharScan::FindChar(p + 2, end, '*');
+          while (end - q > 1 && '/' != q[1]) {
+            q = CharScan::FindChar(q + 1, end, '*');
+          }
+          q = end - q > 1 ? q + 2 : end;
+          countCommentedOut(p, q);
+          p = q;
+        } else if (end - p > 1 && '/' == p[1]) {
+          const char *q = CharScan::FindChar(p, end, '\n');
+          countCommentedOut(p, q);
+          p = q;
+        } else {
+          ++p;
+        }
+      } break;
+      case '"':
+      case '\'': {
+        p = skipLiteral(p, end);
+      } break;
+      case '#': {
+        p = isLineStart(d_data_p, p) ? directive(p, end) : p + 1;
+      } break;
+      default: {
+        ++p;
+      } break;
+    }
+  }
+  d_next_p = p;
+}
+
+void FileDepIteratorImpl::countCommentedOut(const char *begin,
+                                            const char *end) {
+  for (const char *p = CharScan::FindChar(begin, end, '#'); p < end;
+       p = CharScan::FindChar(p + 1, end, '#')) {
+    if (isCommentedOut(d_data_p, p) && isIncludeDirective(p, end)) {
+      ++d_numSkipped;
+    }
+  }
+}
+
+const char *FileDepIteratorImpl::directive(const char *hash,
+                                           const char *end) {
+  const char *lineEnd = CharScan::FindChar(hash, end, '\n');
+
+  const char *p = CharScan::SkipBlanks(hash + 1, lineEnd);
+  const char *word = p;
+  while (p < lineEnd && isIdentifierChar(*p)) {
+    ++p;
+  }
+  const int length = p - word;
+
+#define IDEP_IS_DIRECTIVE(NAME) \
+    (sizeof NAME - 1 == length && 0 == memcmp(word, NAME, length))
+
+  if (IDEP_IS_DIRECTIVE("include")) {
+    int nameLength;
+    char *name = const_cast<char *>(extractDependency(hash, lineEnd,
+                                                      &nameLength));
+    if (!name) {
+      return p;
+    }
+    if (dead()) {
+      ++d_numSkipped;
+      return p;
+    }
+    setHeader(name, nameLength, lineEnd);
+    return name + nameLength < lineEnd ? name + nameLength + 1 : lineEnd;
+  }
+
+  if (IDEP_IS_DIRECTIVE("if")) {
+    openSection(dead() ? IS_UNKNOWN : evaluate(p, lineEnd));
+  } else if (IDEP_IS_DIRECTIVE("ifdef") || IDEP_IS_DIRECTIVE("ifndef")) {
+    Truth t = IS_UNKNOWN;
+    const char *name = CharScan::SkipBlanks(p, lineEnd);
+    const char *nameEnd = name;
+    while (nameEnd < lineEnd && isIdentifierChar(*nameEnd)) {
+      ++nameEnd;
+    }
+    const char *value;
+    switch (d_macros_p->Lookup(name, nameEnd - name, &value)) {
+      case MacroTable::DEFINED: t = IS_TRUE; break;
+      case MacroTable::UNDEFINED: t = IS_FALSE; break;
+      default: break;
+    }
+    if ('n' == word[2] && IS_UNKNOWN != t) {      // #ifndef
+      t = IS_TRUE == t ? IS_FALSE : IS_TRUE;
+    }
+    openSection(nameEnd > name ? t : IS_UNKNOWN);
+  } else if (IDEP_IS_DIRECTIVE("elif")) {
+    const bool decided = d_depth > 0 &&
+                         (d_conditionals_p[d_depth - 1].d_outerDead ||
+                          d_conditionals_p[d_depth - 1].d_taken);
+    nextBranch(decided ? IS_UNKNOWN : evaluate(p, lineEnd));
+  } else if (IDEP_IS_DIRECTIVE("else")) {
+    elseBranch();
+  } else if (IDEP_IS_DIRECTIVE("endif")) {
+    closeSection();
+  }
+
+#undef IDEP_IS_DIRECTIVE
+
+  return p;
+}
+
+Truth FileDepIteratorImpl::evaluate(const char *begin,
+                                    const char *end) const {
+  return ConditionParser(*d_macros_p, begin, end).Parse();
+}
+
+void FileDepIteratorImpl::openSection(Truth condition) {
+  if (d_depth >= d_conditionalSize) {
+    const int size = d_conditionalSize ? d_conditionalSize * GROW_FACTOR
+                                       : START_DEPTH;
+    ConditionalState *tmp = d_conditionals_p;
+    d_conditionals_p = new ConditionalState[size];
+    if (tmp) {
+      memcpy(d_conditionals_p, tmp, d_depth * sizeof *tmp);
+      delete[] tmp;
+    }
+    d_conditionalSize = size;
+  }
+  ConditionalState& s = d_conditionals_p[d_depth];
+  s.d_outerDead = dead();
+  s.d_taken = IS_TRUE == condition;
+  s.d_dead = s.d_outerDead || IS_FALSE == condition;
+  ++d_depth;
+}
+
+void FileDepIteratorImpl::nextBranch(Truth condition) {
+  if (0 == d_depth) {
+    return;                             // unbalanced #elif
+  }
+  ConditionalState& s = d_conditionals_p[d_depth - 1];
+  if (s.d_outerDead || s.d_taken) {
+    s.d_dead = true;
+  } else {
+    s.d_dead = IS_FALSE == condition;
+    s.d_taken = IS_TRUE == condition;
+  }
+}
+
+void FileDepIteratorImpl::elseBranch() {
+  if (0 == d_depth) {
+    return;                             // unbalanced #else
+  }
+  ConditionalState& s = d_conditionals_p[d_depth - 1];
+  s.d_dead = s.d_outerDead || s.d_taken;
+  s.d_taken = true;
+}
+
+void FileDepIteratorImpl::closeSection() {
+  if (d_depth > 0) {
+    --d_depth;
+  }
+}
+
+FileDepIterator::FileDepIterator(const char *fileName,
+                                 const MacroTable *macros)
+    : impl_(new FileDepIteratorImpl(fileName, macros)) {
+  ++*this; // load first occurrence
+}
+
+FileDepIterator::FileDepIterator(char *contents,
+                                 int length,
+                                 const MacroTable *macros)
+    : impl_(new FileDepIteratorImpl(contents, length, macros)) {
   ++*this; // load first occurrence
 }
 
@@ -128,11 +681,9 @@ FileDepIterator::~FileDepIterator() {
 }
 
 void FileDepIterator::Reset() {
-  if (IsValidFile()) {
-    impl_->d_file.seekg(std::ios::beg); // rewind to beginning of file
-    impl_->d_file.clear(impl_->d_file.rdstate() & std::ios::badbit);
-    impl_->d_header_p = impl_->d_buf;
-  }
+  impl_->d_next_p = impl_->d_data_p;
+  impl_->d_depth = 0;
+  impl_->d_numSkipped = 0;
   ++*this; // load first occurrence
 }
 
@@ -141,12 +692,40 @@ bool FileDepIterator::IsValidFile() const {
 }
 
 void FileDepIterator::operator++() {
-  impl_->d_header_p = 0;
-  while (loadBuf(impl_->d_file, impl_->d_buf, sizeof impl_->d_buf) >= 0) {
-    if (impl_->d_header_p = extractDependency(impl_->d_buf)) { // `=' ok
+  FileDepIteratorImpl& impl = *impl_;
+  if (impl.d_macros_p) {
+    impl.scan();
+    return;
+  }
+
+  const char *data = impl.d_data_p;
+  const char *end = data + impl.d_size;
+
+  impl.d_header_p = 0;
+  const char *p = impl.d_next_p;
+  while (p < end) {
+    const char *hash = CharScan::FindChar(p, end, '#');
+    if (hash == end) {
+      p = end;
+      break;
+    }
+    p = hash + 1;
+    if (!isLineStart(data, hash)) {
+      continue;                         // not at the start of a line
+    }
+
+    const char *newline = CharScan::FindChar(hash, end, '\n');
+    p = newline < end ? newline + 1 : end;
+
+    int length;
+    char *name = const_cast<char *>(extractDependency(hash, newline,
+                                                      &length));
+    if (name) {
+      impl.setHeader(name, length, newline);
       break;
     }
   }
+  impl.d_next_p = p;
 }
 
 FileDepIterator::operator const void *() const {
@@ -157,4 +736,8 @@ const char* FileDepIterator::operator()() const {
   return impl_->d_header_p;
 }
 
+int FileDepIterator::NumSkipped() const {
+  return impl_->d_numSkipped;
+}
+
 }  // namespace idep
@@ -6,17 +6,33 @@
 namespace idep {
 
 class FileDepIteratorImpl;
+class MacroTable;
 
 // This component defines 1 fully insulated iterator class:
 // Iterate over the header files included by a file.
 class FileDepIterator {
  public:
-  // Create a compile-time dependency iterator for the specified file.
-  // The filenames in preprocessor include directives will be presented
-  // in the order in which they appear in the file.  Dependencies that
-  // are conditionally compiled or commented out with multi-line
-  // /* ... */ comments will none-the-less be returned by this iterator.
-  FileDepIterator(const char* file_name);
+  // Create a compile-time dependency iterator for the specified file.  The
+  // filenames in preprocessor include directives will be presented in the
+  // order in which they appear in the file; a directive may be indented
+  // with spaces and tabs.  By default, dependencies that are conditionally
+  // compiled or commented out with multi-line /* ... */ comments will
+  // none-the-less be returned by this iterator.  If a macro table is
+  // specified, the iterator instead follows comments, string and character
+  // literals, and #if, #ifdef, #ifndef, #elif, #else and #endif as it goes,
+  // and skips any include directive that is commented out or in a section
+  // that the macros rule out.  Conditions it cannot decide (e.g., ones that
+  // use an unknown macro or arithmetic) count as true, and #define
+  // directives in the file are not followed.  The file is read (or mapped
+  // into memory) in its entirety here, and is not kept open.
+  FileDepIterator(const char* file_name, const MacroTable* macros = 0);
+
+  // Create a compile-time dependency iterator, as above, for a file that
+  // has already been loaded: the specified |length| characters of
+  // contents, which must have been allocated with new[] (or be 0 if
+  // |length| is 0).  This iterator takes ownership of the contents and
+  // may modify them.  The file counts as valid.
+  FileDepIterator(char* contents, int length, const MacroTable* macros = 0);
   ~FileDepIterator();
 
   // Return to the first dependency in the file (if one exists).
@@ -38,6 +54,11 @@ class FileDepIterator {
   // If the iteration state is not valid, 0 is returned.
   const char* operator()() const;
 
+  // Return the number of include directives passed over so far because
+  // they were commented out or conditionally excluded.  This is always 0
+  // if no macro table was specified.
+  int NumSkipped() const;
+
  private:
   FileDepIteratorImpl* impl_;
 
@@ -0,0 +1,182 @@
+// Check the include directives that FileDepIterator finds, and those it
+// skips, with and without a macro table: directives must be recognized
+// by the same rule in both modes (with or without indentation), and
+// given macros, includes that are commented out or in a section ruled
+// out by #if, #ifdef, #ifndef, #elif or #else under the -D and -U
+// options given must be skipped.  Exit with the number of mismatches
+// found.
+
+#include "idep_file_dep_iterator.h"
+#include "idep_macro_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace {
+
+using idep::FileDepIterator;
+using idep::MacroTable;
+
+struct TestCase {
+  const char* source;           // contents of the file
+  const char* options;          // -D and -U options, separated by spaces
+  const char* all;              // names found without macros
+  const char* active;           // names found with the options
+  int skipped;                  // directives skipped with the options
+};
+
+const TestCase kCases[] = {
+  // Directives, indented or not, at the start of a line.
+  { "#include <a.h>\n  #include \"b.h\"\n\t# include <c.h>\n#  include <d>",
+    "", "a.h b.h c.h d", "a.h b.h c.h d", 0 },
+  { "int x; #include <a.h>\n\"#include <b.h>\"\n#define X #include <c.h>\n",
+    "", "", "", 0 },
+  { "#includes <a.h>\n#import <b.h>\n#include\n#include a.h\n",
+    "", "", "", 0 },
+
+  // Commented-out directives.
+  { "/* #include <a.h> */\n// #include <b.h>\n/*\n#include <c.h>\n*/\n"
+    "  #include <d.h> // #include <e.h>\n",
+    "", "c.h d.h", "d.h", 3 },
+  { "const char *s = \"/*\";\n#include <a.h>\nchar c = '\"';\n"
+    "#include <b.h>\n",
+    "", "a.h b.h", "a.h b.h", 0 },
+
+  // #ifdef, #ifndef and #else, decided by -D or -U or not at all.
+  { "#ifdef A\n#include <a.h>\n#else\n#include <b.h>\n#endif\n",
+    "-DA", "a.h b.h", "a.h", 1 },
+  { "#ifdef A\n#include <a.h>\n#else\n#include <b.h>\n#endif\n",
+    "-UA", "a.h b.h", "b.h", 1 },
+  { "#ifdef A\n#include <a.h>\n#else\n#include <b.h>\n#endif\n",
+    "", "a.h b.h", "a.h b.h", 0 },
+  { "  #ifndef A\n  #  include <a.h>\n  #endif\n#include <b.h>\n",
+    "-DA", "a.h b.h", "b.h", 1 },
+  { "#ifndef A\n#include <a.h>\n#endif\n",
+    "-DA -UA", "a.h", "a.h", 0 },
+
+  // #if and #elif.
+  { "#if defined(A) && !B\n#include <a.h>\n#elif B\n#include <b.h>\n"
+    "#else\n#include <c.h>\n#endif\n",
+    "-DA -UB", "a.h b.h c.h", "a.h", 2 },
+  { "#if defined(A) && !B\n#include <a.h>\n#elif B\n#include <b.h>\n"
+    "#else\n#include <c.h>\n#endif\n",
+    "-UA -DB", "a.h b.h c.h", "b.h", 2 },
+  { "#if defined(A) && !B\n#include <a.h>\n#elif B\n#include <b.h>\n"
+    "#else\n#include <c.h>\n#endif\n",
+    "-UA -UB", "a.h b.h c.h", "c.h", 2 },
+  { "#if defined(A) && !B\n#include <a.h>\n#elif B\n#include <b.h>\n"
+    "#else\n#include <c.h>\n#endif\n",
+    "-DA", "a.h b.h c.h", "a.h b.h c.h", 0 },
+  { "#if V\n#include <a.h>\n#endif\n#if V + 1\n#include <b.h>\n#endif\n",
+    "-DV=0", "a.h b.h", "b.h", 1 },
+  { "#if 0\n#if 1\n#include <a.h>\n#endif\n#include <b.h>\n#elif 1\n"
+    "#include <c.h>\n#endif\n#include <d.h>\n",
+    "", "a.h b.h c.h d.h", "c.h d.h", 2 },
+  { "#if 0 /* comment */\n#include <a.h>\n#endif // comment\n"
+    "#include <b.h>\n",
+    "", "a.h b.h", "b.h", 1 },
+};
+const int kNumCases = sizeof kCases / sizeof *kCases;
+
+// Load the options in the specified string into the specified table.
+void Load(MacroTable* macros, const char* options) {
+  std::string option;
+  for (const char* p = options; ; ++p) {
+    if (*p && ' ' != *p) {
+      option += *p;
+      continue;
+    }
+    if (option.size() > 2 && 'D' == option[1])
+      macros->Define(option.c_str() + 2);
+    else if (option.size() > 2 && 'U' == option[1])
+      macros->Undefine(option.c_str() + 2);
+    option.clear();
+    if (!*p)
+      break;
+  }
+}
+
+// Return the names found by the specified iterator, separated by
+// spaces.
+std::string Names(FileDepIterator& it) {
+  std::string names;
+  for (; it; ++it) {
+    if (!names.empty())
+      names += ' ';
+    names += it();
+  }
+  return names;
+}
+
+// Compare the names found in the specified source, and the number of
+// directives skipped, with those expected; return 0 if they are the
+// same, and 1 (after reporting the difference) otherwise.
+int Check(int index, const char* source, const MacroTable* macros,
+          const char* expected, int expectedSkipped, const char* how) {
+  const int length = strlen(source);
+  char* contents = length ? new char[length] : 0;
+  memcpy(contents, source, length);
+  FileDepIterator it(contents, length, macros);
+  const std::string names = Names(it);
+  const int skipped = it.NumSkipped();
+  it.Reset();
+  const std::string again = Names(it);
+  if (names == expected && again == expected &&
+      skipped == expectedSkipped && it.NumSkipped() == expectedSkipped)
+    return 0;
+  printf("FAIL: case %d (%s) found \"%s\" (then \"%s\") and skipped %d "
+         "rather than \"%s\" and %d\n", index, how, names.c_str(),
+         again.c_str(), skipped, expected, expectedSkipped);
+  return 1;
+}
+
+}  // namespace
+
+int main() {
+  int failures = 0;
+  int cases = 0;
+  for (int i = 0; i < kNumCases; ++i) {
+    const TestCase& c = kCases[i];
+    MacroTable macros;
+    Load(&macros, c.options);
+    failures += Check(i, c.source, 0, c.all, 0, "without macros");
+    failures += Check(i, c.source, &macros, c.active, c.skipped,
+                      c.options);
+    cases += 2;
+  }
+
+  // A file read from disk is scanned the same way.
+  char file[] = "/tmp/idep_file_dep_iterator_test.XXXXXX";
+  const int fd = mkstemp(file);
+  if (fd < 0) {
+    printf("FAIL: cannot create a temporary file\n");
+    return failures + 1;
+  }
+  const char* source = kCases[0].source;
+  const bool written = write(fd, source, strlen(source)) ==
+                       ssize_t(strlen(source));
+  close(fd);
+  for (int useMacros = 0; written && useMacros <= 1; ++useMacros) {
+    MacroTable macros;
+    FileDepIterator it(file, useMacros ? &macros : 0);
+    const std::string names = Names(it);
+    ++cases;
+    if (!it.IsValidFile() || names != kCases[0].all) {
+      printf("FAIL: file (%s macros) found \"%s\" rather than \"%s\"\n",
+             useMacros ? "with" : "without", names.c_str(), kCases[0].all);
+      ++failures;
+    }
+  }
+  unlink(file);
+  if (!written) {
+    printf("FAIL: cannot write %s\n", file);
+    ++failures;
+  }
+
+  printf("%d of %d scans are correct.\n", cases - failures, cases);
+  return failures;
+}
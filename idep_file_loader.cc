@@ -0,0 +1,691 @@
+#include "idep_file_loader.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <memory.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+#define IDEP_FILE_LOADER_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// IMPLEMENTATION NOTE: A request goes through the same steps with either
+// engine: its candidate names are opened in turn until one succeeds; the
+// file is then read into a buffer of its size plus one (or READ_SIZE if
+// it has no size), which doubles whenever it fills up, until a read
+// returns 0 or, for a regular file, falls short of the room left.  A
+// pool thread performs the steps of one request with blocking calls.
+// With io_uring, each step of every request in progress is a queue
+// entry (IORING_OP_OPENAT or IORING_OP_READ); when an entry completes,
+// the next step of its request is queued, and the ring is entered once
+// per round to submit all new entries and wait for completions.  There
+// is at most one entry per request in progress, so the rings (which
+// have at least depth entries) never overflow.  The io_uring system
+// calls are made directly, so that no library is needed.
+//
+// Should entering the ring ever fail, the loader falls back to the pool
+// of threads rather than lose the requests in the ring: those not yet
+// started are simply handed to the pool, and each one in flight (the
+// ring keeps its slot in flight_) is restarted from its first candidate
+// as a new request.  The kernel may still write into the buffer of the
+// old request, so that request is abandoned rather than freed.
+
+enum { READ_SIZE = 1 << 16 };           // initial size for unsized files
+enum { DEFAULT_RING_DEPTH = 64, DEFAULT_THREADS = 16 };
+
+namespace idep {
+
+struct LoadRequest {
+  int tag_;
+  char* names_;                 // candidate names, each null-terminated
+  int count_;                   // number of candidate names
+  bool load_;                   // whether to read the file opened
+  int candidate_;               // index of the candidate being tried
+  const char* name_;            // that candidate
+  int fd_;                      // file opened, or -1
+  bool regular_;                // whether that is a regular file
+  char* data_;                  // contents read so far
+  size_t length_;               // number of characters in data_
+  size_t size_;                 // physical size of data_
+  int slot_;                    // index in the ring's flight_, or -1
+  LoadRequest* next_;           // next request in the same queue
+};
+
+static LoadRequest* newRequest(int tag,
+                               const char* const* names,
+                               int count,
+                               bool load_flag) {
+  LoadRequest* r = new LoadRequest;
+  size_t total = 0;
+  for (int i = 0; i < count; ++i)
+    total += strlen(names[i]) + 1;
+  r->names_ = new char[total > 0 ? total : 1];
+  char* p = r->names_;
+  for (int i = 0; i < count; ++i) {
+    const size_t n = strlen(names[i]) + 1;
+    memcpy(p, names[i], n);
+    p += n;
+  }
+  r->tag_ = tag;
+  r->count_ = count;
+  r->load_ = load_flag;
+  r->candidate_ = 0;
+  r->name_ = r->names_;
+  r->fd_ = -1;
+  r->regular_ = false;
+  r->data_ = 0;
+  r->length_ = 0;
+  r->size_ = 0;
+  r->slot_ = -1;
+  r->next_ = 0;
+  return r;
+}
+
+static LoadRequest* copyRequest(const LoadRequest* r) {
+  // Return a new request, not yet started, having the tag, candidate
+  // names and load flag of the specified one.
+  const char** names = new const char*[r->count_ > 0 ? r->count_ : 1];
+  const char* p = r->names_;
+  for (int i = 0; i < r->count_; ++i, p += strlen(p) + 1)
+    names[i] = p;
+  LoadRequest* copy = newRequest(r->tag_, names, r->count_, r->load_);
+  delete[] names;
+  return copy;
+}
+
+static void deleteRequest(LoadRequest* r) {
+  delete[] r->names_;
+  delete[] r->data_;
+  delete r;
+}
+
+static bool nextCandidate(LoadRequest* r) {
+  // Move on to the next candidate name of the specified request; return
+  // false (and set the candidate to -1) if there is none.
+  if (++r->candidate_ >= r->count_) {
+    r->candidate_ = -1;
+    return false;
+  }
+  r->name_ += strlen(r->name_) + 1;
+  return true;
+}
+
+static void startRead(LoadRequest* r) {
+  // Allocate the buffer of the specified request, whose file is open.
+  struct stat status;
+  r->regular_ = 0 == fstat(r->fd_, &status) && S_ISREG(status.st_mode);
+  r->size_ = r->regular_ && status.st_size > 0
+           ? static_cast<size_t>(status.st_size) + 1  // to see end of file
+           : static_cast<size_t>(READ_SIZE);
+  r->data_ = new char[r->size_];
+}
+
+static bool addRead(LoadRequest* r, long n) {
+  // Account for the specified result of a read into the buffer of the
+  // specified request; return true if there may be more to read.
+  if (n <= 0)
+    return false;                       // end of file (or unreadable)
+  r->length_ += n;
+  if (r->length_ == r->size_) {
+    char* tmp = r->data_;
+    r->data_ = new char[r->size_ * 2];
+    memcpy(r->data_, tmp, r->size_);
+    r->size_ *= 2;
+    delete[] tmp;
+    return true;
+  }
+  return !r->regular_;
+}
+
+static void loadBlocking(LoadRequest* r) {
+  // Carry out the specified request with blocking calls.
+  while ((r->fd_ = open(r->name_, O_RDONLY)) < 0) {
+    if (EINTR != errno && !nextCandidate(r))
+      return;
+  }
+  if (r->load_) {
+    startRead(r);
+    for (;;) {
+      const ssize_t n = read(r->fd_, r->data_ + r->length_,
+                             r->size_ - r->length_);
+      if (n < 0 && EINTR == errno)
+        continue;                       // interrupted by a signal
+      if (!addRead(r, n))
+        break;
+    }
+  }
+  close(r->fd_);
+  r->fd_ = -1;
+}
+
+// A first-in, first-out list of requests.
+struct RequestQueue {
+  LoadRequest* head_;
+  LoadRequest* tail_;
+
+  RequestQueue() : head_(0), tail_(0) {}
+
+  bool Empty() const { return 0 == head_; }
+
+  void Push(LoadRequest* r) {
+    r->next_ = 0;
+    if (tail_)
+      tail_->next_ = r;
+    else
+      head_ = r;
+    tail_ = r;
+  }
+
+  LoadRequest* Pop() {
+    LoadRequest* r = head_;
+    head_ = r->next_;
+    if (!head_)
+      tail_ = 0;
+    return r;
+  }
+
+  void Clear() {
+    while (!Empty())
+      deleteRequest(Pop());
+  }
+};
+
+#if IDEP_FILE_LOADER_IO_URING
+
+// The shared rings of an io_uring instance, as mapped into this process.
+struct Ring {
+  int fd_;
+  void* sq_map_;
+  size_t sq_map_size_;
+  void* cq_map_;
+  size_t cq_map_size_;
+  io_uring_sqe* sqes_;
+  size_t sqes_size_;
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+static bool ringInit(Ring* ring, unsigned entries) {
+  // Set up the specified ring with at least the specified number of
+  // entries; return false if io_uring is unavailable or too old.
+  io_uring_params params;
+  memset(&params, 0, sizeof params);
+  ring->fd_ = syscall(__NR_io_uring_setup, entries, &params);
+  if (ring->fd_ < 0)
+    return false;
+  if (!(params.features & IORING_FEAT_RW_CUR_POS)) {     // before 5.6
+    close(ring->fd_);
+    return false;
+  }
+
+  ring->sq_map_size_ = params.sq_off.array +
+                       params.sq_entries * sizeof(unsigned);
+  ring->cq_map_size_ = params.cq_off.cqes +
+                       params.cq_entries * sizeof(io_uring_cqe);
+  const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single && ring->cq_map_size_ > ring->sq_map_size_)
+    ring->sq_map_size_ = ring->cq_map_size_;
+  ring->sq_map_ = mmap(0, ring->sq_map_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd_,
+                       IORING_OFF_SQ_RING);
+  ring->cq_map_ = single || MAP_FAILED == ring->sq_map_
+                ? ring->sq_map_
+                : mmap(0, ring->cq_map_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd_,
+                       IORING_OFF_CQ_RING);
+  ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = MAP_FAILED == ring->cq_map_
+             ? MAP_FAILED
+             : mmap(0, ring->sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd_, IORING_OFF_SQES);
+  if (MAP_FAILED == sqes) {
+    if (MAP_FAILED != ring->cq_map_ && ring->cq_map_ != ring->sq_map_)
+      munmap(ring->cq_map_, ring->cq_map_size_);
+    if (MAP_FAILED != ring->sq_map_)
+      munmap(ring->sq_map_, ring->sq_map_size_);
+    close(ring->fd_);
+    return false;
+  }
+  ring->sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(ring->sq_map_);
+  ring->sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  ring->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  char* cq = static_cast<char*>(ring->cq_map_);
+  ring->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return true;
+}
+
+static void ringFree(Ring* ring) {
+  // Tear down the specified ring; the kernel finishes or cancels any
+  // entries still in flight first.
+  munmap(ring->sqes_, ring->sqes_size_);
+  if (ring->cq_map_ != ring->sq_map_)
+    munmap(ring->cq_map_, ring->cq_map_size_);
+  munmap(ring->sq_map_, ring->sq_map_size_);
+  close(ring->fd_);
+}
+
+static io_uring_sqe* ringEntry(Ring* ring, LoadRequest* r, int opcode) {
+  // Queue, without submitting, an entry of the specified kind for the
+  // specified request, and return it to be filled in.
+  const unsigned tail = *ring->sq_tail_;
+  const unsigned index = tail & ring->sq_mask_;
+  io_uring_sqe* sqe = &ring->sqes_[index];
+  memset(sqe, 0, sizeof *sqe);
+  sqe->opcode = opcode;
+  sqe->user_data = reinterpret_cast<uintptr_t>(r);
+  ring->sq_array_[index] = index;
+  __atomic_store_n(ring->sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  return sqe;
+}
+
+static void queueOpen(Ring* ring, LoadRequest* r) {
+  io_uring_sqe* sqe = ringEntry(ring, r, IORING_OP_OPENAT);
+  sqe->fd = AT_FDCWD;
+  sqe->addr = reinterpret_cast<uintptr_t>(r->name_);
+  sqe->open_flags = O_RDONLY;
+}
+
+static void queueRead(Ring* ring, LoadRequest* r) {
+  io_uring_sqe* sqe = ringEntry(ring, r, IORING_OP_READ);
+  sqe->fd = r->fd_;
+  sqe->addr = reinterpret_cast<uintptr_t>(r->data_ + r->length_);
+  sqe->len = r->size_ - r->length_;
+  sqe->off = r->regular_ ? r->length_ : static_cast<__u64>(-1);
+}
+
+static bool ringWait(Ring* ring) {
+  // Submit every entry queued and wait for at least one completion;
+  // return false on an unexpected error.
+  for (;;) {
+    const unsigned queued = *ring->sq_tail_ -
+                            __atomic_load_n(ring->sq_head_, __ATOMIC_ACQUIRE);
+    if (syscall(__NR_io_uring_enter, ring->fd_, queued, 1,
+                IORING_ENTER_GETEVENTS, 0, 0) >= 0)
+      return true;
+    if (EINTR != errno && EAGAIN != errno && EBUSY != errno)
+      return false;
+  }
+}
+
+#endif  // IDEP_FILE_LOADER_IO_URING
+
+struct FileLoaderImpl {
+  FileLoader::Engine engine_;
+  const int requested_depth_;   // as specified, or 0 for the default
+  int depth_;                   // maximum requests in progress
+  RequestQueue pending_;        // submitted but not yet started
+  RequestQueue done_;           // finished but not yet handed back
+  int active_;                  // started but not yet finished
+
+  // THREADS: pending_, done_ and active_ are guarded by mutex_.
+  pthread_t* threads_;          // started by the first Submit()
+  int num_threads_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t work_cond_;    // a request was submitted, or stopping
+  pthread_cond_t done_cond_;    // a request finished
+  bool stop_;
+
+#if IDEP_FILE_LOADER_IO_URING
+  // IO_URING
+  Ring ring_;
+  LoadRequest** flight_;        // request in each slot of the ring, or 0
+  int* free_;                   // slots of flight_ not in use
+  int num_free_;
+
+  // Put the specified request in the ring and queue its first step.
+  void launch(LoadRequest* r);
+
+  // Take the next step of the specified request given the specified
+  // result of its last step.
+  void step(LoadRequest* r, int result);
+
+  // Close the file of the specified request, if open, and move it to
+  // done_.
+  void finish(LoadRequest* r);
+
+  // Hand the requests in the ring, and those not yet started, to a pool
+  // of threads, which becomes the engine.
+  void fallBack();
+
+  bool nextFromRing(FileLoader::Result* result);
+#endif
+
+  FileLoaderImpl(FileLoader::Engine engine, int depth);
+  ~FileLoaderImpl();
+
+  void startThreads();
+  bool nextFromThreads(FileLoader::Result* result);
+};
+
+static void* runLoader(void* arg) {
+  FileLoaderImpl* impl = static_cast<FileLoaderImpl*>(arg);
+  pthread_mutex_lock(&impl->mutex_);
+  for (;;) {
+    while (impl->pending_.Empty() && !impl->stop_)
+      pthread_cond_wait(&impl->work_cond_, &impl->mutex_);
+    if (impl->pending_.Empty())
+      break;                            // stopping
+    LoadRequest* r = impl->pending_.Pop();
+    ++impl->active_;
+    pthread_mutex_unlock(&impl->mutex_);
+
+    loadBlocking(r);
+
+    pthread_mutex_lock(&impl->mutex_);
+    --impl->active_;
+    impl->done_.Push(r);
+    pthread_cond_signal(&impl->done_cond_);
+  }
+  pthread_mutex_unlock(&impl->mutex_);
+  return 0;
+}
+
+FileLoaderImpl::FileLoaderImpl(FileLoader::Engine engine, int depth)
+    : engine_(engine),
+      requested_depth_(depth > 0 ? depth : 0),
+      depth_(depth),
+      active_(0),
+      threads_(0),
+      num_threads_(0),
+      stop_(false) {
+  pthread_mutex_init(&mutex_, 0);
+  pthread_cond_init(&work_cond_, 0);
+  pthread_cond_init(&done_cond_, 0);
+
+#if IDEP_FILE_LOADER_IO_URING
+  flight_ = 0;
+  free_ = 0;
+  num_free_ = 0;
+  if (FileLoader::IO_URING == engine_ || FileLoader::AUTO == engine_) {
+    if (depth_ <= 0)
+      depth_ = DEFAULT_RING_DEPTH;
+    if (ringInit(&ring_, depth_)) {
+      engine_ = FileLoader::IO_URING;
+      flight_ = new LoadRequest*[depth_];
+      free_ = new int[depth_];
+      for (int i = 0; i < depth_; ++i) {
+        flight_[i] = 0;
+        free_[num_free_++] = depth_ - 1 - i;
+      }
+      return;
+    }
+  }
+#endif
+
+  engine_ = FileLoader::THREADS;
+  if (depth <= 0)
+    depth_ = DEFAULT_THREADS;
+}
+
+FileLoaderImpl::~FileLoaderImpl() {
+#if IDEP_FILE_LOADER_IO_URING
+  if (FileLoader::IO_URING == engine_) {
+    // The requests in flight are known only to the ring, and the kernel
+    // may still be writing into their buffers, so let them finish.
+    pending_.Clear();
+    FileLoader::Result result;
+    while (nextFromRing(&result))
+      delete[] result.contents;
+    if (FileLoader::IO_URING == engine_)
+      ringFree(&ring_);                 // else fallBack() freed it
+  }
+  delete[] flight_;
+  delete[] free_;
+#endif
+
+  if (threads_) {
+    pthread_mutex_lock(&mutex_);
+    pending_.Clear();
+    stop_ = true;
+    pthread_cond_broadcast(&work_cond_);
+    pthread_mutex_unlock(&mutex_);
+    for (int i = 0; i < num_threads_; ++i)
+      pthread_join(threads_[i], 0);
+    delete[] threads_;
+  }
+  pending_.Clear();
+  done_.Clear();
+
+  pthread_cond_destroy(&done_cond_);
+  pthread_cond_destroy(&work_cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void FileLoaderImpl::startThreads() {
+  threads_ = new pthread_t[depth_];
+  for (num_threads_ = 0; num_threads_ < depth_; ++num_threads_) {
+    if (0 != pthread_create(&threads_[num_threads_], 0, runLoader, this))
+      break;
+  }
+  assert(num_threads_ > 0);
+}
+
+static void takeResult(LoadRequest* r, FileLoader::Result* result) {
+  // Load the outcome of the specified finished request into |result|
+  // and free the request.
+  result->tag = r->tag_;
+  result->candidate = r->candidate_;
+  result->contents = r->data_;
+  result->length = r->length_;
+  r->data_ = 0;
+  deleteRequest(r);
+}
+
+bool FileLoaderImpl::nextFromThreads(FileLoader::Result* result) {
+  pthread_mutex_lock(&mutex_);
+  while (done_.Empty() && (!pending_.Empty() || active_ > 0))
+    pthread_cond_wait(&done_cond_, &mutex_);
+  LoadRequest* r = done_.Empty() ? 0 : done_.Pop();
+  pthread_mutex_unlock(&mutex_);
+
+  if (!r)
+    return false;
+  takeResult(r, result);
+  return true;
+}
+
+#if IDEP_FILE_LOADER_IO_URING
+
+void FileLoaderImpl::step(LoadRequest* r, int result) {
+  const bool interrupted = -EINTR == result || -EAGAIN == result;
+  if (r->fd_ < 0) {                     // opening
+    if (interrupted) {
+      queueOpen(&ring_, r);
+      return;
+    }
+    if (result < 0) {
+      if (nextCandidate(r))
+        queueOpen(&ring_, r);
+      else
+        finish(r);
+      return;
+    }
+    r->fd_ = result;
+    if (!r->load_) {
+      finish(r);
+      return;
+    }
+    startRead(r);
+    queueRead(&ring_, r);
+    return;
+  }
+
+  if (interrupted || addRead(r, result))  // reading
+    queueRead(&ring_, r);
+  else
+    finish(r);
+}
+
+void FileLoaderImpl::finish(LoadRequest* r) {
+  if (r->fd_ >= 0) {
+    close(r->fd_);
+    r->fd_ = -1;
+  }
+  flight_[r->slot_] = 0;
+  free_[num_free_++] = r->slot_;
+  r->slot_ = -1;
+  --active_;
+  done_.Push(r);
+}
+
+void FileLoaderImpl::launch(LoadRequest* r) {
+  r->slot_ = free_[--num_free_];
+  flight_[r->slot_] = r;
+  ++active_;
+  queueOpen(&ring_, r);
+}
+
+void FileLoaderImpl::fallBack() {
+  // The requests already started go ahead of those not yet started.
+  RequestQueue started;
+  for (int i = 0; i < depth_; ++i) {
+    LoadRequest* r = flight_[i];
+    if (!r)
+      continue;
+    if (r->fd_ >= 0)
+      close(r->fd_);
+    started.Push(copyRequest(r));       // r itself is abandoned
+    flight_[i] = 0;
+  }
+  while (!pending_.Empty())
+    started.Push(pending_.Pop());
+  pending_ = started;
+  num_free_ = 0;
+  active_ = 0;
+  ringFree(&ring_);
+
+  engine_ = FileLoader::THREADS;
+  depth_ = requested_depth_ > 0 ? requested_depth_ : DEFAULT_THREADS;
+  if (!pending_.Empty())
+    startThreads();
+}
+
+bool FileLoaderImpl::nextFromRing(FileLoader::Result* result) {
+  while (done_.Empty()) {
+    while (active_ < depth_ && !pending_.Empty())
+      launch(pending_.Pop());
+    if (0 == active_)
+      return false;
+
+    if (!ringWait(&ring_)) {
+      fallBack();
+      return nextFromThreads(result);
+    }
+
+    unsigned head = *ring_.cq_head_;
+    const unsigned tail = __atomic_load_n(ring_.cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = ring_.cqes_[head & ring_.cq_mask_];
+      step(reinterpret_cast<LoadRequest*>(cqe.user_data), cqe.res);
+    }
+    __atomic_store_n(ring_.cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  takeResult(done_.Pop(), result);
+  return true;
+}
+
+#endif  // IDEP_FILE_LOADER_IO_URING
+
+static const char* const kEngineNames[FileLoader::NUM_ENGINES] = {
+  "auto", "io_uring", "threads"
+};
+
+FileLoader::FileLoader(Engine engine, int depth)
+    : impl_(new FileLoaderImpl(engine, depth)) {
+}
+
+FileLoader::~FileLoader() {
+  delete impl_;
+}
+
+void FileLoader::Submit(int tag,
+                        const char* const* names,
+                        int count,
+                        bool load_flag) {
+  LoadRequest* r = newRequest(tag, names, count, load_flag);
+  if (THREADS == impl_->engine_) {
+    pthread_mutex_lock(&impl_->mutex_);
+    if (!impl_->threads_)
+      impl_->startThreads();
+    impl_->pending_.Push(r);
+    pthread_cond_signal(&impl_->work_cond_);
+    pthread_mutex_unlock(&impl_->mutex_);
+  } else {
+    impl_->pending_.Push(r);
+  }
+}
+
+bool FileLoader::Next(Result* result) {
+#if IDEP_FILE_LOADER_IO_URING
+  if (IO_URING == impl_->engine_)
+    return impl_->nextFromRing(result);
+#endif
+  return impl_->nextFromThreads(result);
+}
+
+FileLoader::Engine FileLoader::Current() const {
+  return impl_->engine_;
+}
+
+bool FileLoader::IsSupported(Engine engine) {
+  switch (engine) {
+    case AUTO:
+    case THREADS:
+      return true;
+#if IDEP_FILE_LOADER_IO_URING
+    case IO_URING: {
+      static int s_supported = -1;      // not yet known
+      if (s_supported < 0) {
+        Ring ring;
+        s_supported = ringInit(&ring, 1);
+        if (s_supported)
+          ringFree(&ring);
+      }
+      return s_supported;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+bool FileLoader::Find(const char* name, Engine* engine) {
+  for (int e = 0; e < NUM_ENGINES; ++e) {
+    if (0 == strcmp(name, kEngineNames[e])) {
+      *engine = static_cast<Engine>(e);
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* FileLoader::Name(Engine engine) {
+  return engine >= 0 && engine < NUM_ENGINES ? kEngineNames[engine] : 0;
+}
+
+}  // namespace idep
@@ -0,0 +1,75 @@
+#ifndef IDEP_FILE_LOADER_H_
+#define IDEP_FILE_LOADER_H_
+
+#include "basictypes.h"
+
+namespace idep {
+
+struct FileLoaderImpl;
+
+// This leaf component defines 1 fully insulated class:
+// Load many whole files at once, each from the first of a list of
+// candidate names that can be opened, and hand them back in the order in
+// which they finish.  By default the loads are carried out by io_uring
+// if the kernel supports it, and by a pool of threads doing ordinary
+// blocking reads otherwise.  Either way, requests may be submitted while
+// earlier ones are still in progress, so that the files named in one
+// file can be queued as soon as that file has been scanned.
+class FileLoader {
+ public:
+  enum Engine {
+    AUTO,           // IO_URING if supported here, else THREADS
+    IO_URING,       // Linux io_uring: one thread, many reads in flight
+    THREADS,        // a pool of threads doing blocking reads
+    NUM_ENGINES     // must be last entry
+  };
+
+  // The outcome of one request.
+  struct Result {
+    int tag;            // as specified to Submit()
+    int candidate;      // index of the name opened, or -1 if none was
+    char* contents;     // contents of that file, allocated with new[] and
+                        // owned by the caller (0 if none were loaded)
+    int length;         // number of characters in contents
+  };
+
+  // Create a loader that uses the specified engine (AUTO if it is not
+  // supported here) and keeps at most the specified number of requests
+  // in progress at once (0 for a default suited to the engine).
+  explicit FileLoader(Engine engine = AUTO, int depth = 0);
+
+  // Wait for any requests still in progress and discard their results.
+  ~FileLoader();
+
+  // Queue a request, identified by the specified tag, to open the first
+  // of the specified |count| candidate names that can be opened for
+  // reading and, if |load_flag| is true, to read all of it.  The names
+  // are copied.
+  void Submit(int tag, const char* const* names, int count, bool load_flag);
+
+  // Wait until a request finishes and load its outcome into |result|.
+  // Return false if no request is queued or in progress.
+  bool Next(Result* result);
+
+  // Return the engine in use (never AUTO).
+  Engine Current() const;
+
+  // Return true if the specified engine can be used on this system.
+  static bool IsSupported(Engine engine);
+
+  // Load into |engine| the engine having the specified name ("auto",
+  // "io_uring" or "threads"); return false if there is none.
+  static bool Find(const char* name, Engine* engine);
+
+  // Return the name of the specified engine.
+  static const char* Name(Engine engine);
+
+ private:
+  FileLoaderImpl* impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileLoader);
+};
+
+}  // namespace idep
+
+#endif  // IDEP_FILE_LOADER_H_
@@ -0,0 +1,206 @@
+// Check that every FileLoader engine -- io_uring (where supported), the
+// thread pool, the default, and io_uring falling back to the thread pool
+// when its ring fails -- finds the same candidate names and loads the
+// same contents, and that with one request in progress at a time the
+// results come back in the order submitted.  Exit with the number of
+// mismatches found.
+
+#include "idep_file_loader.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using idep::FileLoader;
+
+enum { NUM_FILES = 40, NUM_REQUESTS = 3 * NUM_FILES };
+
+// Sizes around the 64 KB buffer a file without a size starts with.
+const int kSizes[] = { 0, 1, 100, 4095, 4096, 65535, 65536, 65537, 200000 };
+const int kNumSizes = sizeof kSizes / sizeof *kSizes;
+
+struct Fixture {
+  std::string dir;
+  std::vector<std::string> contents;    // of each file
+  std::vector<std::string> names;       // of each file
+  std::string missing;                  // a name that does not exist
+};
+
+// Create the files of the specified fixture; return false on failure.
+bool Create(Fixture* f) {
+  char dir[] = "/tmp/idep_file_loader_test.XXXXXX";
+  if (!mkdtemp(dir))
+    return false;
+  f->dir = dir;
+  f->missing = f->dir + "/missing";
+  for (int i = 0; i < NUM_FILES; ++i) {
+    char name[32];
+    sprintf(name, "/f%d", i);
+    std::string text;
+    for (int k = 0; k < kSizes[i % kNumSizes]; ++k)
+      text += 0 == (k + 1) % 61 ? '\n' : char('a' + (k * 7 + i) % 26);
+    f->names.push_back(f->dir + name);
+    f->contents.push_back(text);
+    FILE* out = fopen(f->names.back().c_str(), "w");
+    if (!out)
+      return false;
+    const bool ok = fwrite(text.data(), 1, text.size(), out) == text.size();
+    if (0 != fclose(out) || !ok)
+      return false;
+  }
+  return true;
+}
+
+void Destroy(const Fixture& f) {
+  for (size_t i = 0; i < f.names.size(); ++i)
+    unlink(f.names[i].c_str());
+  rmdir(f.dir.c_str());
+}
+
+// Request r names file r % NUM_FILES: loaded, behind a missing name, or
+// only opened, for the three thirds of the requests.  Every fifth
+// request of the second third names no file that exists.
+void Submit(FileLoader* loader, const Fixture& f, int r) {
+  const char* names[2];
+  int count = 0;
+  if (r >= NUM_FILES)
+    names[count++] = f.missing.c_str();
+  if (r < NUM_FILES || r >= 2 * NUM_FILES || 0 != r % 5)
+    names[count++] = f.names[r % NUM_FILES].c_str();
+  loader->Submit(r, names, count, r < 2 * NUM_FILES);
+}
+
+// Return a description of the expected outcome of request r.
+std::string Expected(const Fixture& f, int r) {
+  char buffer[32];
+  if (r >= NUM_FILES && r < 2 * NUM_FILES && 0 == r % 5)
+    return "none";
+  sprintf(buffer, "candidate %d, ", r < NUM_FILES ? 0 : 1);
+  return buffer + (r < 2 * NUM_FILES ? f.contents[r % NUM_FILES]
+                                     : std::string("not loaded"));
+}
+
+// Return a description of the specified outcome.
+std::string Actual(const FileLoader::Result& result) {
+  char buffer[32];
+  if (result.candidate < 0)
+    return result.contents ? "none, but loaded" : "none";
+  sprintf(buffer, "candidate %d, ", result.candidate);
+  return buffer + (result.contents
+                   ? std::string(result.contents, result.length)
+                   : std::string("not loaded"));
+}
+
+// Submit every request to a loader using the specified engine and
+// depth, half of them before the first result is taken and the rest
+// after, and check the outcomes.  If closeRing is set, close the ring
+// of the loader right away, so that it must fall back.  Return the
+// number of mismatches.
+int Check(const Fixture& f, FileLoader::Engine engine, int depth,
+          bool closeRing) {
+  char label[64];
+  sprintf(label, "%s%s, depth %d", FileLoader::Name(engine),
+          closeRing ? " (ring failed)" : "", depth);
+
+  // The ring is the only descriptor the loader opens when created.
+  const int probe = open("/dev/null", O_RDONLY);
+  close(probe);
+  FileLoader loader(engine, depth);
+  if (closeRing) {
+    char path[32];
+    char link[64] = "";
+    sprintf(path, "/proc/self/fd/%d", probe);
+    const ssize_t n = readlink(path, link, sizeof link - 1);
+    if (n <= 0 || !strstr(link, "io_uring")) {
+      printf("FAIL: %s: cannot find the ring\n", label);
+      return 1;
+    }
+    close(probe);
+  }
+
+  int failures = 0;
+  std::vector<int> seen(NUM_REQUESTS, 0);
+  int submitted = 0;
+  int expectedTag = 0;
+  for (; submitted < NUM_REQUESTS / 2; ++submitted)
+    Submit(&loader, f, submitted);
+  FileLoader::Result result;
+  while (loader.Next(&result)) {
+    for (; submitted < NUM_REQUESTS; ++submitted)
+      Submit(&loader, f, submitted);
+    const int r = result.tag;
+    if (r < 0 || r >= NUM_REQUESTS || seen[r]++) {
+      printf("FAIL: %s: unexpected tag %d\n", label, r);
+      ++failures;
+    } else if (Actual(result) != Expected(f, r)) {
+      printf("FAIL: %s: request %d finds %.40s rather than %.40s\n",
+             label, r, Actual(result).c_str(), Expected(f, r).c_str());
+      ++failures;
+    }
+    if (1 == depth && r != expectedTag++) {
+      printf("FAIL: %s: request %d finishes out of order\n", label, r);
+      ++failures;
+    }
+    delete[] result.contents;
+  }
+  for (int r = 0; r < NUM_REQUESTS; ++r) {
+    if (!seen[r]) {
+      printf("FAIL: %s: request %d never finishes\n", label, r);
+      ++failures;
+    }
+  }
+
+  const FileLoader::Engine current = loader.Current();
+  if (closeRing ? FileLoader::THREADS != current
+                : FileLoader::AUTO == engine
+                  ? current != (FileLoader::IsSupported(FileLoader::IO_URING)
+                                ? FileLoader::IO_URING : FileLoader::THREADS)
+                  : engine != current) {
+    printf("FAIL: %s: engine in use is %s\n", label,
+           FileLoader::Name(current));
+    ++failures;
+  }
+  return failures;
+}
+
+}  // namespace
+
+int main() {
+  Fixture f;
+  if (!Create(&f)) {
+    printf("FAIL: cannot create the test files\n");
+    Destroy(f);
+    return 1;
+  }
+
+  const bool ring = FileLoader::IsSupported(FileLoader::IO_URING);
+  if (!ring)
+    printf("io_uring is not supported here; testing threads only.\n");
+
+  const int depths[] = { 1, 4, 0 };
+  const int numDepths = sizeof depths / sizeof *depths;
+
+  int failures = 0;
+  int cases = 0;
+  for (int d = 0; d < numDepths; ++d) {
+    failures += 0 != Check(f, FileLoader::THREADS, depths[d], false);
+    failures += 0 != Check(f, FileLoader::AUTO, depths[d], false);
+    cases += 2;
+    if (ring) {
+      failures += 0 != Check(f, FileLoader::IO_URING, depths[d], false);
+      failures += 0 != Check(f, FileLoader::IO_URING, depths[d], true);
+      cases += 2;
+    }
+  }
+  Destroy(f);
+
+  printf("%d of %d loads are correct.\n", cases - failures, cases);
+  return failures;
+}
@@ -2,13 +2,15 @@
 
 #include "idep_alias_table.h"
 #include "idep_alias_util.h"
-#include "idep_binary_relation.h"
+#include "idep_condensation.h"
 #include "idep_name_array.h"
 #include "idep_name_index_map.h"
+#include "idep_sparse_relation.h"
 #include "idep_token_iterator.h"
 
 #include <assert.h>
 #include <ctype.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <math.h>
@@ -38,23 +40,22 @@ static bool IsLocal(const char* dir_file) {
   return !strchr(dir_file, '/');
 }
 
-static char* removeFileName(char* dirPath) {
-  char *slash = strrchr(dirPath, '/');
-  if (slash) {
-    slash[1] = '\0';
-  }
-  else {
-    dirPath[0] = '\0';
-  }
-  return dirPath;
+static int removeFileName(const char* dirPath, int length) {
+  // Return the length of the specified path without its final file name.
+  while (length > 0 && '/' != dirPath[length - 1])
+    --length;
+  return length;
 }
 
-static char* removeSuffix(char* dirPath) {
-    char *dot = strrchr(dirPath, '.');
-    if (dot && !strchr(dot, '/')) {
-        dot[0] = '\0';
+static int removeSuffix(const char* dirPath, int length) {
+    // Return the length of the specified path without the suffix, if any,
+    // of its final segment.
+    for (int i = length - 1; i >= 0 && '/' != dirPath[i]; --i) {
+        if ('.' == dirPath[i]) {
+            return i;
+        }
     }
-    return dirPath;
+    return length;
 }
 
 static int digits(int n) {
@@ -92,13 +93,20 @@ struct idep_LinkDep_i {
     idep::NameArray d_dependencyFiles;       // hold compile-time dependencies
 
     idep::NameIndexMap *d_componentNames_p;  // keys for relation
-    idep::BinaryRelation *d_dependencies_p;          // compile-time dependencies
+    idep::SparseRelation *d_edges_p;         // direct dependencies as parsed
+    idep::Condensation *d_condensation_p;    // strong components and closure
+    idep::SparseRelation *d_reduced_p;       // canonical dependencies among
+                                             // strong components (if any)
     int *d_map_p;                           // map to levelized order   
+    int *d_order_p;                         // position of each in d_map_p
+    int *d_representatives_p;               // first member of each strong
+                                            // component in levelized order
     int *d_levels_p;                        // number of components per level
     int *d_levelNumbers_p;                  // level number for each component
     int *d_cycles_p;                        // labels components in each cycle
     int *d_weights_p;                       // number of components per cycle
     int *d_cycleIndices_p;                  // consecutive cycle index
+    int *d_contributions_p;                 // CCD term for each component
     int d_numComponents;                    // number of components in system
     int d_numLevels;                        // number of levels in system 
     int d_numCycles;                        // number of cycles in system
@@ -108,21 +116,30 @@ struct idep_LinkDep_i {
     idep_LinkDep_i();
     ~idep_LinkDep_i();
 
-    int entry(const char *name, int suffixFlag);
+    int entry(const char *name, int length, int suffixFlag);
     void loadDependencies(istream& in, int suffixFlag);
     void createCycleArray();
+    void levelize(int *strongLevels);
+    void countDependencies(const int *strongLevels);
+    void reduceDependencies();
+    int *dependencies(int component, int *numDependencies) const;
     int calculate(std::ostream& orf, int canonicalFlag, int suffixFlag);
 };
 
 idep_LinkDep_i::idep_LinkDep_i() 
 : d_componentNames_p(0)
-, d_dependencies_p(0)
+, d_edges_p(0)
+, d_condensation_p(0)
+, d_reduced_p(0)
 , d_map_p(0)
+, d_order_p(0)
+, d_representatives_p(0)
 , d_levels_p(0)
 , d_levelNumbers_p(0)
 , d_cycles_p(0)
 , d_weights_p(0)
 , d_cycleIndices_p(0)
+, d_contributions_p(0)
 , d_numComponents(-1)
 , d_numLevels(-1)
 , d_numCycles(-1)
@@ -134,59 +151,50 @@ idep_LinkDep_i::idep_LinkDep_i()
 idep_LinkDep_i::~idep_LinkDep_i() 
 {
     delete d_componentNames_p;
-    delete d_dependencies_p; // crash here ! 
+    delete d_edges_p;
+    delete d_condensation_p;
+    delete d_reduced_p;
     delete d_map_p;
+    delete [] d_order_p;
+    delete [] d_representatives_p;
     delete d_levels_p;
     delete d_levelNumbers_p;
     delete d_cycles_p;
     delete d_weights_p;
     delete d_cycleIndices_p;
+    delete [] d_contributions_p;
 }
 
-int idep_LinkDep_i::entry(const char *name, int suffixFlag) 
+int idep_LinkDep_i::entry(const char *name, int length, int suffixFlag) 
 {
-    int size = strlen(name) + 1;
-    char *buf = new char[size];
-    memcpy(buf, name, size);
-
-    if (!IsLocal(buf)) {
-        removeFileName(buf);
-        if (d_unaliases.GetIndexByName(buf) >= 0) {     // found unalias
-            memcpy(buf, name, size);                    // restore buffer
+    // The component name is a prefix of the specified name, so it is
+    // looked up in place rather than copied.
+
+    if (!IsLocal(name)) {
+        int dirLength = removeFileName(name, length);
+        if (d_unaliases.GetIndexByName(name, dirLength) < 0) { // no unalias
+            length = dirLength;
         }
     }
 
     if (suffixFlag) {
-        removeSuffix(buf);
+        length = removeSuffix(name, length);
     }
 
-    const char *componentName = d_aliases.Lookup(buf);
-    if (!componentName) {
-        const char SLASH_CHAR = '/';
-        const char NULL_CHAR = '\0';
-        int len = strlen(buf);
-        int last = len - 1;
-        if (SLASH_CHAR == buf[last]) {             // If the input ends in '/' 
-            buf[last] = NULL_CHAR;                 // try removing the '/' and
-            componentName = d_aliases.Lookup(buf); // checking for that alias.
-            if (!componentName) {
-                buf[last] = SLASH_CHAR; // restore
-            }
-        }
+    const char *componentName = d_aliases.Lookup(name, length);
+    if (!componentName && length > 0 && '/' == name[length - 1]) {
+        // If the input ends in '/' try removing the '/' and checking for
+        // that alias.
+        componentName = d_aliases.Lookup(name, length - 1);
     }
 
-    if (!componentName) {
-        componentName = buf;
+    int numNames = d_componentNames_p->Length();
+    int index = componentName ? d_componentNames_p->Entry(componentName)
+                              : d_componentNames_p->Entry(name, length);
+    if (d_componentNames_p->Length() > numNames) {
+        d_edges_p->appendEntry();
     }
 
-    int length = d_componentNames_p->Length();
-    int index = d_componentNames_p->Entry(componentName);
-    if (d_componentNames_p->Length() > length) {
-        d_dependencies_p->appendEntry();
-    }
-
-    delete [] buf;
-
     return index;
 }
 
@@ -217,11 +225,12 @@ void idep_LinkDep_i::loadDependencies(istream& in, int suffixFlag)
         }
         else {
             if (INVALID_INDEX == fromIndex) {
-                fromIndex = entry(it(), suffixFlag); // start of new sequence
+                fromIndex = entry(it(), it.Length(), suffixFlag);
+                                                     // start of new sequence
             }
             else {                                   // found a dependency
-                int toIndex = entry(it(), suffixFlag);     
-                d_dependencies_p->set(fromIndex, toIndex); 
+                int toIndex = entry(it(), it.Length(), suffixFlag);
+                d_edges_p->set(fromIndex, toIndex);
             }
             lastTokenWasNewline = 0;                 // record newline state
         }
@@ -255,51 +264,277 @@ void idep_LinkDep_i::createCycleArray()
     d_numCycles = 0;                    // # of unique design cycles
     d_numMembers = 0;                   // # of cyclicly-dependent components
 
-    // Load the cycle array.  For each cycle detected, the non-negative 
-    // index of the lowest participating component is used as a tag to 
-    // identify that cycle.  For each component we will scan ahead to see 
-    // on what other components this component is mutually dependent.  
-    // If one or more is found, each of these locations will be set to 
-    // the index value of the first (primary) component in the cycle.  
-    // Ideally there will be no cycles, in which case each entry in the 
-    // array will be left set to -1.  We will use the cycle array initially 
-    // to report all cyclic dependencies and again later to facilitate
-    // the levelization algorithm in the presence of cycles.
+    // Load the cycle array.  A cycle is a strong component of the
+    // dependency graph having more than one member.  For each cycle
+    // detected, the non-negative index of the lowest participating
+    // component is used as a tag to identify that cycle, and each member
+    // is set to that index.  Ideally there will be no cycles, in which case
+    // each entry in the array will be left set to -1.  We will use the
+    // cycle array initially to report all cyclic dependencies and again
+    // later to facilitate the levelization algorithm in the presence of
+    // cycles.  Since each strong component is visited once, this takes
+    // linear time.
+
+    const idep::Condensation& scc = *d_condensation_p;
+    for (int c = 0; c < scc.Length(); ++c) {
+        const int size = scc.numMembers(c);
+        if (size > 1) {
+            const int *members = scc.members(c);
+            for (int m = 0; m < size; ++m) {
+                d_cycles_p[members[m]] = members[0];  // lowest member
+                d_weights_p[members[m]] = size;       // weight of cycle
+            }
+            d_numMembers += size;       // total # of members in cycles
+            ++d_numCycles;
+        }
+    }
+}
 
-    for (int i = 0; i < d_numComponents; ++i) { 
-        if (d_cycles_p[i] >= 0) {
-            continue;               // part of a previously reported cycle
+struct NameLess {
+    // Order component indices by name.
+    const idep::NameIndexMap *names;
+
+    bool operator()(int left, int right) const {
+        return strcmp((*names)[left], (*names)[right]) < 0;
+    }
+};
+
+void idep_LinkDep_i::levelize(int *strongLevels)
+{
+    // Assign every component to a level and sort the components into
+    // levelized order, loading the level of each strong component into the
+    // specified array.
+    //
+    // A component that depends on nothing is at level 0; otherwise it is
+    // one level above the highest component on which it depends.  The
+    // members of a cycle of weight w all share one level, which is w
+    // levels above the highest component outside the cycle on which it
+    // depends (or at level w - 1 if there is none), as though the members
+    // were stacked on one another.  The strong components are numbered in
+    // reverse topological order, so each level follows from those of the
+    // direct successors, which come first: this is linear in the number
+    // of edges.  Within each level, components are sorted by name to make
+    // them easier to find and to provide a canonical order to facilitate
+    // finding differences as software is modified (e.g., via the Unix
+    // diff command); the members of a cycle thus come out in name order,
+    // and the first of them represents the cycle.
+
+    const idep::Condensation& scc = *d_condensation_p;
+    const int numStrong = scc.Length();
+
+    d_numLevels = 0;
+    for (int c = 0; c < numStrong; ++c) {
+        int level = -1;                 // highest level depended upon
+        const int *p = scc.successors(c);
+        for (int k = scc.numSuccessors(c); k > 0; --k) {
+            const int l = strongLevels[*p++];
+            if (l > level) {
+                level = l;
+            }
+        }
+        const int size = scc.numMembers(c);
+        strongLevels[c] = level + (size > 1 ? size : 1);
+        if (strongLevels[c] >= d_numLevels) {
+            d_numLevels = strongLevels[c] + 1;
         }
-        int cycleFound = 0;
-        d_cycles_p[i] = i;          // first component in potential cycle
-        for (int j = i + 1; j < d_numComponents; ++j) {
-            if (d_cycles_p[j] >= 0) {
-                continue;           // part of a previously reported cycle
+    }
+    assert(d_numLevels <= d_numComponents);
+
+    for (int l = 0; l < d_numLevels; ++l) {
+        d_levels_p[l] = 0;
+    }
+    for (int i = 0; i < d_numComponents; ++i) {
+        d_levelNumbers_p[i] = strongLevels[scc.component(i)];
+        ++d_levels_p[d_levelNumbers_p[i]];
+    }
+
+    // Order the components by level (counting sort), then by name.
+    int *next = new int[d_numLevels + 1];
+    next[0] = 0;
+    for (int l = 0; l < d_numLevels; ++l) {
+        next[l + 1] = next[l] + d_levels_p[l];
+    }
+    for (int i = 0; i < d_numComponents; ++i) {
+        d_map_p[next[d_levelNumbers_p[i]]++] = i;
+    }
+    delete [] next;
+
+    NameLess less = { d_componentNames_p };
+    int start = 0;
+    for (int l = 0; l < d_numLevels; ++l) {
+        const int top = start + d_levels_p[l];
+        std::sort(d_map_p + start, d_map_p + top, less);
+        start = top;
+    }
+
+    for (int i = 0; i < d_numComponents; ++i) {
+        d_order_p[d_map_p[i]] = i;
+    }
+    for (int c = 0; c < numStrong; ++c) {
+        const int *members = scc.members(c);
+        int rep = members[0];
+        for (int m = scc.numMembers(c) - 1; m > 0; --m) {
+            if (d_order_p[members[m]] < d_order_p[rep]) {
+                rep = members[m];
             }
-            if (d_dependencies_p->get(i, j) && d_dependencies_p->get(j, i)) { 
-                cycleFound = 1;     // record that we have a cycle
-                d_cycles_p[j] = i;  // record index of first component
+        }
+        d_representatives_p[c] = rep;
+    }
+}
+
+void idep_LinkDep_i::countDependencies(const int *strongLevels)
+{
+    // Load the CCD term of each component into d_contributions_p and their
+    // sum into d_ccd, given the level of each strong component.  The term
+    // of a component is the number of components it depends on, ignoring
+    // all level 0 components, plus unit weight for itself unless it is at
+    // level 0 or already counted as depending on itself (as in a cycle).
+    // Every member of a strong component depends on the same components,
+    // so the term is computed once per strong component, straight from
+    // its closure; no relation is copied or modified.
+
+    const int numStrong = d_condensation_p->Length();
+    d_contributions_p = new int[d_numComponents];
+    int *reached = new int[numStrong > 0 ? numStrong : 1];
+
+    int sum = 0;
+
+    for (int c = 0; c < numStrong; ++c) {
+        const int numReached = d_condensation_p->reached(c, reached);
+        int contribution = 0;
+        for (int k = 0; k < numReached; ++k) {
+            if (0 != strongLevels[reached[k]]) {
+                contribution += d_condensation_p->numMembers(reached[k]);
             }
         }
-        if (cycleFound) {           // if cycle found involving component `i'
-            int weight = 0;
-            for (int j = i; j < d_numComponents; ++j) { // find each cycle member
-                if (d_cycles_p[j] == i) {
-                    ++weight;       // # members in this cycle
-                }
+        if (0 != strongLevels[c] && !d_condensation_p->isCyclic(c)) {
+            ++contribution; // each component contributes unit weight
+        }
+        const int *members = d_condensation_p->members(c);
+        for (int m = d_condensation_p->numMembers(c); m > 0; --m) {
+            d_contributions_p[*members++] = contribution;
+            sum += contribution;
+        }
+    }
+
+    d_ccd = sum;        // Cache this value -- too hard to calculate later.
+
+    delete [] reached;
+}
+
+void idep_LinkDep_i::reduceDependencies()
+{
+    // Determine the canonical dependencies among strong components: those
+    // left by removing every redundant dependency from the (transitive)
+    // dependency relation in levelized order, as makeNonTransitive would.
+    //
+    // In levelized order, every component on which a strong component S
+    // depends outside of S comes before all members of S.  Warshall's
+    // reduction then leaves the first member of S in that order as its
+    // representative: the representative alone depends on the other
+    // members of S and on the representative of each strong component
+    // that S reaches directly but not by way of another, while the other
+    // members depend only on the representative.  Only that set of
+    // strong components needs to be recorded.
+    //
+    // A successor T of S that is reachable by way of another successor U
+    // has a lower number than U (numbers are in reverse topological
+    // order).  Taking the successors of S from the highest number down,
+    // U is therefore retained or covered before T is considered, and
+    // every component reached from a retained successor is marked as
+    // covered.  Each strong component thus costs one pass over its direct
+    // successors and one pass over the closure of each one retained.
+
+    const idep::Condensation& scc = *d_condensation_p;
+    const int numStrong = scc.Length();
+
+    d_reduced_p = new idep::SparseRelation(numStrong);
+    char *covered = new char[numStrong > 0 ? numStrong : 1];
+    int *reached = new int[numStrong > 0 ? numStrong : 1];
+    int *touched = new int[numStrong > 0 ? numStrong : 1];
+    memset(covered, 0, numStrong);
+
+    for (int c = 0; c < numStrong; ++c) {
+        int numTouched = 0;
+        const int *succ = scc.successors(c);
+        for (int k = scc.numSuccessors(c) - 1; k >= 0; --k) {
+            const int t = succ[k];
+            if (covered[t]) {
+                continue;           // implied by a successor retained earlier
             }
-            for (int j = i; j < d_numComponents; ++j) { // find each cycle member
-                if (d_cycles_p[j] == i) {
-                    d_weights_p[j] = weight;  // store weight for each member
+            d_reduced_p->set(c, t);
+            const int numReached = scc.reached(t, reached);
+            for (int i = 0; i < numReached; ++i) {
+                if (!covered[reached[i]]) {
+                    covered[reached[i]] = 1;
+                    touched[numTouched++] = reached[i];
                 }
             }
-            d_numMembers += weight;   // total # of members in cycles   
-            ++d_numCycles;
+        }
+        for (int i = 0; i < numTouched; ++i) {
+            covered[touched[i]] = 0;
+        }
+    }
+    d_reduced_p->freeze();
+
+    delete [] touched;
+    delete [] reached;
+    delete [] covered;
+}
+
+int *idep_LinkDep_i::dependencies(int component, int *numDependencies) const
+{
+    // Return a new array holding, in increasing order, the positions in
+    // levelized order of the components on which the specified component
+    // depends: every component it reaches, or only those not implied by
+    // others if the dependencies were reduced (see reduceDependencies).
+
+    const idep::Condensation& scc = *d_condensation_p;
+    const int c = scc.component(component);
+    const int rep = d_representatives_p[c];
+    int count = 0;
+    int *positions;
+
+    if (d_reduced_p) {
+        if (component != rep) {
+            positions = new int[1];
+            positions[count++] = d_order_p[rep];
         }
         else {
-            d_cycles_p[i] = NO_CYCLE; // component `i' is not part of a cycle
+            const int *members = scc.members(c);
+            const int *succ = d_reduced_p->successors(c);
+            const int numSucc = d_reduced_p->numSuccessors(c);
+            positions = new int[scc.numMembers(c) + numSucc];
+            for (int m = 0; m < scc.numMembers(c); ++m) {
+                if (members[m] != rep) {
+                    positions[count++] = d_order_p[members[m]];
+                }
+            }
+            for (int k = 0; k < numSucc; ++k) {
+                positions[count++] = d_order_p[d_representatives_p[succ[k]]];
+            }
+        }
+    }
+    else {
+        int *reached = new int[scc.numReached(c) + 1];
+        const int numReached = scc.reached(c, reached);
+        int total = 0;
+        for (int i = 0; i < numReached; ++i) {
+            total += scc.numMembers(reached[i]);
+        }
+        positions = new int[total + 1];
+        for (int i = 0; i < numReached; ++i) {
+            const int *members = scc.members(reached[i]);
+            for (int m = scc.numMembers(reached[i]); m > 0; --m) {
+                positions[count++] = d_order_p[*members++];
+            }
         }
+        delete [] reached;
     }
+
+    std::sort(positions, positions + count);
+    *numDependencies = count;
+    return positions;
 }
 
 int idep_LinkDep_i::calculate(std::ostream& orf, int canonicalFlag, int suffixFlag)
@@ -308,21 +543,33 @@ int idep_LinkDep_i::calculate(std::ostream& orf, int canonicalFlag, int suffixFl
 
     // clean up any previous calculation artifacts
     delete d_componentNames_p;  
-    delete d_dependencies_p;
+    delete d_edges_p;
+    delete d_condensation_p;
+    delete d_reduced_p;
     delete d_map_p;
+    delete [] d_order_p;
+    delete [] d_representatives_p;
     delete d_levels_p;
     delete d_levelNumbers_p;
     delete d_cycles_p;
     delete d_weights_p;
     delete d_cycleIndices_p;
+    delete [] d_contributions_p;
 
     // allocate new data structures for this calculation
     d_componentNames_p = new idep::NameIndexMap;
-    d_dependencies_p = new idep::BinaryRelation;
+    d_edges_p = new idep::SparseRelation;
+    d_condensation_p = 0;       // allocated later when edges are known
+    d_reduced_p = 0;            // allocated later if canonical
     d_map_p = 0;                // allocated later when length is known
+    d_order_p = 0;              // allocated later when length is known
+    d_representatives_p = 0;    // allocated later when length is known
     d_levels_p = 0;             // allocated later when length is known
     d_levelNumbers_p = 0;       // allocated later when length is known
     d_cycles_p = 0;             // allocated later when length is known
+    d_weights_p = 0;            // allocated later when length is known
+    d_cycleIndices_p = 0;       // allocated later when length is known
+    d_contributions_p = 0;      // allocated later when length is known
     d_numLevels = -1;           // invalidate for now
     d_numComponents = -1;       // invalidate for now (-1 value is important)
     d_numCycles = -1;           // invalidate for now
@@ -331,12 +578,16 @@ int idep_LinkDep_i::calculate(std::ostream& orf, int canonicalFlag, int suffixFl
 
     // Now try to read dependencies from specified set of files.
     // If an I/O error occurs, abort; otherwise keep on processing.
+    // Every name read is looked up among the unaliases, which no longer
+    // change.
+
+    d_unaliases.Freeze();
 
     for (int i = 0; i < d_dependencyFiles.Length(); ++i) {
         const int INSANITY = 1000;
-        if (d_dependencies_p->Length() > INSANITY) {
+        if (d_edges_p->Length() > INSANITY) {
             orf << "SANITY CHECK: Number of components is currently " 
-               << d_dependencies_p->Length() << " !!!!" << endl;
+               << d_edges_p->Length() << " !!!!" << endl;
 
         }
         enum { IOERROR = -1 };
@@ -359,203 +610,41 @@ int idep_LinkDep_i::calculate(std::ostream& orf, int canonicalFlag, int suffixFl
 
     // We can now allocate fixed size arrays:
 
-    d_numComponents = d_dependencies_p->Length();
+    d_edges_p->freeze();
+    d_numComponents = d_edges_p->Length();
     assert (d_componentNames_p->Length() == d_numComponents);
 
-    // Create the level array for component name indices.  We will fill in the 
-    // level array with the number of components on each level.  
+    // Condense the (direct) dependency graph into the DAG of its strong
+    // components, which is closed transitively one component at a time.
+    // The strong components with more than one member are the cycles.
+    // Everything below is computed from the DAG and its closure, so the
+    // time and memory needed grow with the number of components and
+    // dependencies (and the size of the closure), never with the square
+    // of the number of components.
 
-    d_levels_p = new int[d_numComponents]; // will holds # of components/level
-    d_numLevels = 0;                       // initially there are no levels
-
-    // Create the level number array to hold the level number for each 
-    // component.  This array will be filled in at the end of this function.
+    d_condensation_p = new idep::Condensation(*d_edges_p);
+    const int numStrong = d_condensation_p->Length();
 
-    d_levelNumbers_p = new int[d_numComponents]; // will holds level #'s
+    createCycleArray();  // determine and label members of all cycles
 
-    // Create the mapping array for component name indices.  This array
-    // will hold the sorted indices of the original component names.
+    // Create the level array for component name indices, the level number
+    // array to hold the level number for each component, and the mapping
+    // array, which will hold the indices of the component names in
+    // levelized order, along with its inverse.
 
+    d_levels_p = new int[d_numComponents]; // will holds # of components/level
+    d_levelNumbers_p = new int[d_numComponents]; // will holds level #'s
     d_map_p = new int[d_numComponents]; // array of levelized component indices
-    int pIndex = 0;                     // current length of mapping
-
-    // Create an array of byte vectors.  Each byte vector identifies the 
-    // components that are below the indicated level index.  The rows are 
-    // allocated as the levels in the system are defined, beginning with level 
-    // corresponding to d_numLevels = 0.  At the end of this calculation, the 
-    // first d_numLevels + 1 byte vectors in this array must be deleted 
-    // explicitly.
-    //
-    // level
-    // index
-    //       +-------+   
-    //   N   |   ?   |
-    //       +-------+
-    //  N-1  |   ?   |         +----------------------------------+
-    //       +-------+         | `i' is defined to be d_numLevels |
-    //       :       :         +----------------------------------+---+
-    //       :       :         | `N' is defined to be d_numComponents |
-    //       +-------+         +--------------------------------------+
-    //  i+1  |   ?   |
-    //       +-------+
-    //   i   |   o---|--->[ 1 ][ 1 ][ 0 ][ 1 ][ 1 ][ 1 ][ 0 ] ... [ 0 ]
-    //       +-------+
-    //       :       :
-    //       :       :
-    //       +-------+
-    //   1   |   o---|--->[ 0 ][ 1 ][ 0 ][ 0 ][ 1 ][ 0 ][ 0 ] ... [ 0 ]
-    //       +-------+
-    //   0   |   o---|--->[ 0 ][ 0 ][ 0 ][ 0 ][ 0 ][ 0 ][ 0 ] ... [ 0 ]
-    //       +-------+    
-    // component index:     0    1    2    3    4    5    6        N-1
-
-    char **lowerThan = new char *[d_numComponents + 1]; // array of byte sets 
-
-    lowerThan[0] = new char[d_numComponents];  // set of lower-level components
-    memset(lowerThan[0], 0, d_numComponents);  // initially this set is empty
-    char *current = new char[d_numComponents]; // components on current level
-
-    d_dependencies_p->makeTransitive(); // perform transitive closure algorithm
-
-    createCycleArray();            // determine and label members of all cycles
-
-    // We can now use the transitive dependency relation to sort the 
-    // components in this system into levelized order (provided the
-    // graph is asyclic).  In order to facilitate the levelization 
-    // algorithm, the principal members of each cycle will be temporarily 
-    // stripped of their dependency on the other members of that cycle.
-    // All of the remaining members will be ignored by the levelization
-    // algorithm (by marking them as already belonging to a lower level). 
-
-    for (int i = 0; i < d_numComponents; ++i) {
-        if (d_cycles_p[i] == i) {
-            for (int j = i + 1; j < d_numComponents; ++j) {
-                if (d_cycles_p[j] == i) {
-                    assert(d_dependencies_p->get(i,j));
-                    d_dependencies_p->clr(i,j); // strip cyclic dependency
-                    lowerThan[0][j] = 1; // ignore other members in algorithm
-                }
-            }
-        }
-    }
-
-    // We will now construct the levelized array of component indices.  For
-    // each level in this system, we will examine each component in the system
-    // to see if it depends on any higher level components.  Note that we have 
-    // already stripped out cyclic dependencies as described above.  If a 
-    // component is part of a lower level we will ignore it.  Otherwise, we 
-    // will check to see if that component depends on any other components 
-    // that are _not_ at a lower level.  If so, the component is skipped over; 
-    // otherwise the component index is added to the current level and 
-    // appended to the end of the levelized list.  If this index corresponds
-    // to the principal member of a cycle, we use the weight of the cycle to 
-    // determine the level below the current level to use to to check
-    // dependencies.  If the principal member of the cycle depends only on
-    // components at a level "weight" (or more) lower than the current level,
-    // all other members are immediately appended to the list in their
-    // original order.  At this point, we restore the cyclic dependencies of 
-    // that principal component on the other members of its cycle.  After 
-    // iterating through all of the components, the number of components on 
-    // the current level is appended to the level array and the current level 
-    // set is united with the lower level set.  This process repeats until all
-    // components are assigned a level.
-
-    while (pIndex < d_numComponents) {  // not all components assigned a level
-        int componentCount = 0;         // number of components on this level
-        memset(current, 0, d_numComponents); // initially current level empty
-        
-        for (int i = 0; i < d_numComponents; ++i) {
-            if (d_cycles_p[i] >= 0 && d_cycles_p[i] != i) {
-                continue;   // component is non principal member of a cycle
-            }
-
-            if (lowerThan[d_numLevels][i]) {    
-                continue;   // already at a lower level;
-            }
+    d_order_p = new int[d_numComponents];
+    d_representatives_p = new int[numStrong];
+    int *strongLevels = new int[numStrong];
 
-            int weight = 1; // weight of non-cyclically dependent component
-
-            if (d_cycles_p[i] == i) {   // if principal member of cycle
-                weight = d_weights_p[i];
-                if (d_weights_p[i] > d_numLevels + 1) {
-                    continue; // weight of cycle two heigh for current level
-                }
-            }
-
-            int searchLevel = d_numLevels + 1 - weight; // allowed dependencies
-
-	    int j=0;
-            for (j = 0; j < d_numComponents; ++j) {
-                if (i == j) {
-                    continue;
-                }
-                if (d_dependencies_p->get(i,j) && !lowerThan[searchLevel][j]) {
-                    break; // depends on component not at or below search level
-                }
-            }
-            if (j < d_numComponents) {
-                continue;   // consider next candidate i
-            }
-            current[i] = 1; // record component as being at the current level
-            d_map_p[pIndex++] = i; // append component in levelized order
-            ++componentCount;   
-            if (d_cycles_p[i] == i) {   // if principal member of a cycle
-                for (j = i + 1; j < d_numComponents; ++j) {
-                    if (d_cycles_p[j] == i) {  // if other member of this cycle
-                        d_map_p[pIndex++] = j; // append it to current level
-                        ++componentCount;
-                        d_dependencies_p->set(i,j); // restore dependencies
-                    }
-                }
-            }
-        }
-
-        // advance to next level
-        for (int i = 0; i < d_numComponents; ++i) {
-            current[i] |= lowerThan[d_numLevels][i]; 
-        }
-        d_levels_p[d_numLevels++] = componentCount; // components per level
-        lowerThan[d_numLevels] = current;    // attach new lower level
-        current = new char[d_numComponents]; // reallocate current array
-    }
-
-    assert (pIndex == d_numComponents);
-
-    // at this point we can load the level number array
-
-    int start = 0;
-
-    for (int i = 0; i < d_numLevels; ++i) {
-        int top = start + d_levels_p[i];
-        for (int j = start; j < top; ++j) {
-            d_levelNumbers_p[d_map_p[j]] = i;
-        }
-        start = top;
-    }
-
-    // Sort components within each level lexicographically to make names 
-    // easier to find and to provide a canonical order to facilitate finding
-    // differences as software is modified (e.g., via the Unix diff command).
-
-    start = 0;
-    for (int k = 0; k < d_numLevels; ++k) {
-        int top = start + d_levels_p[k];
-        for (int i = start + 1; i < top; ++i) {
-            for (int j = start; j < i; ++j) {
-               if (strcmp((*d_componentNames_p)[d_map_p[i]],
-                          (*d_componentNames_p)[d_map_p[j]]) < 0) {
-                    int tmp = d_map_p[i];
-                    d_map_p[i] = d_map_p[j];
-                    d_map_p[j] = tmp;
-                }
-            }
-        }
-        start = top;
-    }
+    levelize(strongLevels);
 
     // We can now uses the cycles array and the level map to create the 
     // cycleIndex array.  This array assigns all components of each cycle
-    // a unique cycle index (in increasing order w.r.t. level).
+    // a unique cycle index (in increasing order w.r.t. level and, within
+    // a level, in the order of the lexicographically smallest member).
 
     int cycleCount = 0;
     for (int i = 0; i < d_numComponents; ++i) { 
@@ -563,113 +652,25 @@ int idep_LinkDep_i::calculate(std::ostream& orf, int canonicalFlag, int suffixFl
         if (label < 0) {
             continue; // not part of any cycle
         }
-
-        const int index = d_cycleIndices_p[d_map_p[i]];
-        if (index >= 0 && index < cycleCount) {
-            continue; // part of lower level cycle
-        }
-
-        // Found the next cycle, go through the remander of the sequence and
-        // annotate each correspondingly labeled component with current cycle 
-        // index in the cycleIndices array.
-
-        for (int j = i; j < d_numComponents; ++j) { 
-            if (label == d_cycles_p[d_map_p[j]]) {
-                d_cycleIndices_p[d_map_p[j]] = cycleCount;
-            }
+        if (d_cycleIndices_p[label] < 0) {  // found the next cycle
+            d_cycleIndices_p[label] = cycleCount++;
         }
-
-        ++cycleCount;
+        d_cycleIndices_p[d_map_p[i]] = d_cycleIndices_p[label];
     }
 
     assert(cycleCount == d_numCycles);
 
-    // Now sort components within each level again, but this time
-    // group cyclically dependent components together in order of
-    // cycle index to facilitate understanding of cycle composition.
-    // The previous sort ensured that cycle indices will be in the
-    // order of the lexicographically smallest member of the cycle
-    // on a given level.
-
-    start = 0;
-    for (int k = 0; k < d_numLevels; ++k) {
-        int top = start + d_levels_p[k];
-        for (int i = start + 1; i < top; ++i) {
-            for (int j = start; j < i; ++j) {
-                int ci = d_cycleIndices_p[d_map_p[i]];
-                int cj = d_cycleIndices_p[d_map_p[j]];
-                if ((ci < cj || ci == cj) &&
-                    strcmp((*d_componentNames_p)[d_map_p[i]],
-                           (*d_componentNames_p)[d_map_p[j]]) < 0) {
-                    int tmp = d_map_p[i];
-                    d_map_p[i] = d_map_p[j];
-                    d_map_p[j] = tmp;
-                }
-            }
-        }
-        start = top;
-    }
-
-    // Clean up local data structures.
-    for (int i = 0; i <= d_numLevels; ++i) {
-        delete [] lowerThan[i];
-    }
-    delete [] lowerThan;
-    delete [] current;
-
     // Calculate CCD and cache the value in a data member of the object.
-    idep::BinaryRelation tmp = *d_dependencies_p; // temporary for calculating CCD
-    for (int i = 0; i < d_numComponents; ++i) {
-        if (0 == d_levelNumbers_p[i]) { 
-            for (int j = 0; j < d_numComponents; ++j) {
-                tmp.clr(j, i); // ignore dependencies on all level 0 components
-            }
-        }
-        else {
-            tmp.set(i, i);     // each component itself contributes unit weight
-        }
-    }
 
-    int sum = 0;
-
-    for (int i = 0; i < d_numComponents; ++i) {
-        for (int j = 0; j < d_numComponents; ++j) {
-            if (tmp.get(i,j)) {
-                ++sum;
-            }
-        }
-    }
-
-    d_ccd = sum;        // Cache this value -- too hard to calculate later.
+    countDependencies(strongLevels);
+    delete [] strongLevels;
 
     if (canonicalFlag) {
-        // In order to ensure a canonical representations with redundant
-        // dependencies removed, it is necessary to create a canonical
-        // sorted binary relation based on the d_map_p array.  After removing
-        // transitive entries from that relation, the results are then mapped 
-        // back to the d_dependencies_p relation.
-
-        idep::BinaryRelation tmp(d_numComponents);
-
-        for (int i = 0; i < d_numComponents; ++i) {
-            int u = d_map_p[i];
-            for (int j = 0; j < d_numComponents; ++j) {
-                int v = d_map_p[j];
-                int bit = d_dependencies_p->get(u, v);
-                tmp.set(i, j, bit);
-            }
-        }
+        // Remove redundant dependencies to provide a canonical
+        // representation, as determined by the levelized order in the
+        // d_map_p array.
 
-        tmp.makeNonTransitive();
-
-        for (int i = 0; i < d_numComponents; ++i) {
-            int u = d_map_p[i];
-            for (int j = 0; j < d_numComponents; ++j) {
-                int v = d_map_p[j];
-                int bit = tmp.get(i, j);
-                d_dependencies_p->set(u, v, bit);
-            }
-        }
+        reduceDependencies();
     }
 
     return d_numMembers;
@@ -737,7 +738,7 @@ int idep_LinkDep::readUnaliasDirectories(const char *file)
 
     for (idep::TokenIterator it(in); it; ++it) {
         if ('\n' != *it()) {
-            d_this->d_unaliases.Add(it());
+            d_this->d_unaliases.Add(it(), it.Length());
         }
     }
 
@@ -892,14 +893,13 @@ void idep_LinkDep::printLevels(std::ostream& o, int longFlag, int supressFlag) c
             o << cit();
 
             if (numCycles() > 0 && !supressFlag) {
-                char field[100]; // will always be large enough
-                ostringstream f(string(field, sizeof field));
-                f << CY_LT << cit.cycle() << CY_RT << ends;
+                ostringstream field;
+                field << CY_LT << cit.cycle() << CY_RT;
                 o.width(cycleFieldWidth);
                 if (cit.cycle()) {
                     std::_Ios_Fmtflags oldState = o.flags();
                     o.setf(ios::left, ios::adjustfield);
-                    o << field;
+                    o << field.str();
                     o.flags(oldState);
                 }
                 else {
@@ -951,8 +951,6 @@ inline const char* AppendSIfNecessary(int n) {
 void idep_LinkDep::printSummary(std::ostream& o) const
 {
     std::_Ios_Fmtflags iostate = o.setf(ios::left, ios::adjustfield);
-    const int FIELD_BUFFER_SIZE = 100;   // Not completely arbitrary -- this
-    char field[FIELD_BUFFER_SIZE];       // size will be always big enough!
     o << "SUMMARY:" << endl;
 
     const int N = 12;           // width of number field
@@ -961,78 +959,77 @@ void idep_LinkDep::printSummary(std::ostream& o) const
 
     if (numCycles() > 0) {
         {
-            std::ostringstream f(string(field, sizeof field));
+            std::ostringstream f;
             f.width(N);
             f << numCycles() << " Cycle"
-              << AppendSIfNecessary(numCycles()) << ends;
+              << AppendSIfNecessary(numCycles());
             o.width(W);
-            o << field;
+            o << f.str();
         }
         o.width(G);
         o << "";
         {
-            std::ostringstream f(string(field, sizeof field));
+            std::ostringstream f;
             f.width(N);
-            f << numMembers() << " Members" << ends;
+            f << numMembers() << " Members";
             o.width(W);
-            o << field;
+            o << f.str();
         }
         o << endl;
     }
     {
-        printf("%d\n", numLocalComponents());
-        ostringstream f(string(field, sizeof field));
+        ostringstream f;
         f.width(N);
         f << numLocalComponents() << " Component"
-          << AppendSIfNecessary(numLocalComponents()) << ends;
+          << AppendSIfNecessary(numLocalComponents());
         o.width(W);
-        o << field;
+        o << f.str();
     }
     o.width(G);
     o << "";
     {
-        ostringstream f(string(field, sizeof field));
+        ostringstream f;
         f.width(N);
         f << numLevels() << " Level"
-          << AppendSIfNecessary(numLevels()) << ends;
+          << AppendSIfNecessary(numLevels());
         o.width(W);
-        o << field;
+        o << f.str();
     }
     o.width(G);
     o << "";
     {
-        ostringstream f(string(field, sizeof field));
+        ostringstream f;
         f.width(N);
         f << numPackages() << " Package"
-          << AppendSIfNecessary(numPackages()) << ends;
+          << AppendSIfNecessary(numPackages());
         o.width(W);
-        o << field;
+        o << f.str();
     }
     o << std::endl;
     {
-        std::ostringstream f(string(field, sizeof field));
+        std::ostringstream f;
         f.width(N);
-        f << ccd() << " CCD" << ends;
+        f << ccd() << " CCD";
         o.width(W);
-        o << field;
+        o << f.str();
     }
     o.width(G);
     o << "";
     {
-        std::ostringstream f(string(field, sizeof field));
+        std::ostringstream f;
         f.width(N);
-        f << acd() << " ACD" << ends;
+        f << acd() << " ACD";
         o.width(W);
-        o << field;
+        o << f.str();
     }
     o.width(G);
     o << "";
     { 
-        ostringstream f(string(field, sizeof field));
+        ostringstream f;
         f.width(N);
-        f << nccd() << " NCCD" << ends;
+        f << nccd() << " NCCD";
         o.width(W);
-        o << field;
+        o << f.str();
     }
     o << endl;
 
@@ -1193,6 +1190,7 @@ struct idep_MemberIter_i {
     const idep_LinkDep_i& d_dep;
     const int d_cycleIndex;
     int d_index;
+    int d_remaining;        // members not yet visited, including current
 
     idep_MemberIter_i(const idep_CycleIter_i& iter);
 };
@@ -1201,6 +1199,7 @@ idep_MemberIter_i::idep_MemberIter_i(const idep_CycleIter_i& iter)
 : d_dep(iter.d_dep)
 , d_cycleIndex(iter.d_cycleIndex)
 , d_index(iter.d_componentIndex)
+, d_remaining(iter.d_dep.d_weights_p[iter.d_dep.d_map_p[iter.d_componentIndex]])
 {
 }
 
@@ -1219,6 +1218,10 @@ idep_MemberIter::~idep_MemberIter()
 void idep_MemberIter::operator++() 
 {
     assert(*this);
+    if (0 == --d_this->d_remaining) {   // no need to scan any further
+        d_this->d_index = d_this->d_dep.d_numComponents;
+        return;
+    }
     do {
         ++d_this->d_index;
     } 
@@ -1334,23 +1337,34 @@ int idep_ComponentIter::cycle() const {
       d_this->d_dep.d_map_p[d_this->d_index]] + 1;
 }
 
+int idep_ComponentIter::ccd() const {
+  return d_this->d_dep.d_contributions_p[
+      d_this->d_dep.d_map_p[d_this->d_index]];
+}
+
 struct DependencyIteratorImpl {
     const idep_LinkDep_i& d_dep;
-    int d_row;
-    int d_col;
+    int *d_positions_p;     // dependencies in levelized order
+    int d_numPositions;
+    int d_index;
 
     DependencyIteratorImpl(const idep_ComponentIter_i& iter);
+    ~DependencyIteratorImpl();
 };
 
 DependencyIteratorImpl::DependencyIteratorImpl(const idep_ComponentIter_i& iter) 
     : d_dep(iter.d_dep),
-      d_row(iter.d_dep.d_map_p[iter.d_index]),
-      d_col(-1){
+      d_positions_p(iter.d_dep.dependencies(iter.d_dep.d_map_p[iter.d_index],
+                                            &d_numPositions)),
+      d_index(0) {
+}
+
+DependencyIteratorImpl::~DependencyIteratorImpl() {
+  delete [] d_positions_p;
 }
 
 DependencyIterator::DependencyIterator(const idep_ComponentIter& iter) 
     : d_this(new DependencyIteratorImpl(*iter.d_this)) {
-  ++*this;
 }
 
 DependencyIterator::~DependencyIterator() {
@@ -1359,32 +1373,27 @@ DependencyIterator::~DependencyIterator() {
 
 void DependencyIterator::operator++()  {
   assert(*this);
-  do {
-    ++d_this->d_col;
-  }
-  while (*this && // look in levelized order
-      !d_this->d_dep.d_dependencies_p->get(d_this->d_row,
-          d_this->d_dep.d_map_p[d_this->d_col]));
+  ++d_this->d_index;
 }
 
 DependencyIterator::operator const void *() const {
-  return d_this->d_col < d_this->d_dep.d_numComponents ? this : 0;
+  return d_this->d_index < d_this->d_numPositions ? this : 0;
 }
 
 const char* DependencyIterator::operator()() const {
   // Levelized order.
   return (*d_this->d_dep.d_componentNames_p)[
-      d_this->d_dep.d_map_p[d_this->d_col]];
+      d_this->d_dep.d_map_p[d_this->d_positions_p[d_this->d_index]]];
 }
 
 int DependencyIterator::level() const {
   // Levelized order.
   return d_this->d_dep.d_levelNumbers_p[
-      d_this->d_dep.d_map_p[d_this->d_col]];
+      d_this->d_dep.d_map_p[d_this->d_positions_p[d_this->d_index]]];
 }
 
 int DependencyIterator::cycle() const {
   // Levelized order.
   return d_this->d_dep.d_cycleIndices_p[
-      d_this->d_dep.d_map_p[d_this->d_col]] + 1;
+      d_this->d_dep.d_map_p[d_this->d_positions_p[d_this->d_index]]] + 1;
 }
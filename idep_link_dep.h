@@ -359,6 +359,11 @@ class idep_ComponentIter {
 
     int cycle() const;
         // return the positive index of the current cycle or 0 if acyclic.
+
+    int ccd() const;
+        // Return the contribution of the current component to the CCD of
+        // the system: the number of components above level 0 on which it
+        // depends, including itself unless it is at level 0.
 };
 
 class DependencyIteratorImpl;
@@ -0,0 +1,171 @@
+// Check that the CCD contribution of every component, and the CCD of the
+// system, are those of the original dense calculation: copy the closure
+// of the dependencies, clear the columns of the level 0 components, set
+// the diagonal of every other component, and count the 1's in each row.
+// The dependencies are random, with and without cycles.  Exit with the
+// number of mismatches found.
+
+#include "idep_binary_relation.h"
+#include "idep_link_dep.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+using idep::BinaryRelation;
+
+// Return the next value of a small linear congruential generator, so
+// that the dependencies, and any mismatch reported, are the same
+// everywhere.
+unsigned Random(unsigned *state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+// Return the index of the component of the specified name ("c<index>").
+int Index(const char *name) {
+    return atoi(name + 1);
+}
+
+// Write the dependencies of the specified relation, in the format read by
+// idep_LinkDep, to the specified file.  Return 0 on success.
+int Write(const char *file, const BinaryRelation& rel) {
+    std::ofstream out(file);
+    for (int i = 0; i < rel.Length(); ++i) {
+        out << 'c' << i;
+        for (int j = 0; j < rel.Length(); ++j) {
+            if (rel.get(i, j)) {
+                out << " c" << j;
+            }
+        }
+        out << "\n\n";
+    }
+    return out ? 0 : -1;
+}
+
+// Return the number of mismatches between the CCD of the specified
+// dependencies as calculated by idep_LinkDep (read from the specified
+// file) and as calculated from the dense closure.
+int Check(const char *file, const BinaryRelation& rel, int canonicalFlag) {
+    idep_LinkDep dep;
+    dep.addDependencyFile(file);
+    std::ostringstream err;
+    if (dep.calculate(err, canonicalFlag) < 0) {
+        printf("FAIL: %s", err.str().c_str());
+        return 1;
+    }
+
+    const int length = rel.Length();
+    int *levels = new int[length];
+    int *ccds = new int[length];
+    for (idep_LevelIter level(dep); level; ++level) {
+        for (idep_ComponentIter component(level); component; ++component) {
+            levels[Index(component())] = level();
+            ccds[Index(component())] = component.ccd();
+        }
+    }
+
+    BinaryRelation tmp(rel);
+    tmp.makeTransitive();
+    for (int i = 0; i < length; ++i) {
+        if (0 == levels[i]) {
+            for (int j = 0; j < length; ++j) {
+                tmp.clr(j, i);
+            }
+        }
+        else {
+            tmp.set(i, i);
+        }
+    }
+
+    int failures = 0;
+    int sum = 0;
+    for (int i = 0; i < length; ++i) {
+        int count = 0;
+        for (int j = 0; j < length; ++j) {
+            count += tmp.get(i, j);
+        }
+        sum += count;
+        if (ccds[i] != count) {
+            printf("FAIL: c%d contributes %d rather than %d "
+                   "(length %d, %s)\n", i, ccds[i], count, length,
+                   canonicalFlag ? "canonical" : "transitive");
+            ++failures;
+        }
+    }
+    if (dep.ccd() != sum) {
+        printf("FAIL: CCD is %d rather than %d (length %d, %s)\n",
+               dep.ccd(), sum, length,
+               canonicalFlag ? "canonical" : "transitive");
+        ++failures;
+    }
+
+    delete [] ccds;
+    delete [] levels;
+    return failures;
+}
+
+}  // namespace
+
+int main() {
+    const int sizes[] = { 1, 2, 10, 63, 64, 65, 300, 1000 };
+    const int numSizes = sizeof sizes / sizeof *sizes;
+
+    // Dependencies per component: from a forest of small trees to a
+    // system dominated by one large cycle.
+    const double densities[] = { 0.5, 1.0, 2.0, 8.0 };
+    const int numDensities = sizeof densities / sizeof *densities;
+
+    char file[] = "/tmp/idep_link_dep_test.XXXXXX";
+    const int fd = mkstemp(file);
+    if (fd < 0) {
+        printf("FAIL: cannot create a temporary file\n");
+        return 1;
+    }
+    close(fd);
+
+    int failures = 0;
+    int cases = 0;
+    for (int s = 0; s < numSizes; ++s) {
+        for (int d = 0; d < numDensities; ++d) {
+            for (int acyclicFlag = 0; acyclicFlag <= 1; ++acyclicFlag) {
+                const int length = sizes[s];
+                const int edges = int(densities[d] * length);
+
+                // Acyclic dependencies only go from higher to lower
+                // indices.
+                BinaryRelation rel(length);
+                unsigned state = 7919u * length + d;
+                for (int e = 0; e < edges; ++e) {
+                    int row = Random(&state) % length;
+                    int col = Random(&state) % length;
+                    if (!acyclicFlag || row > col) {
+                        rel.set(row, col);
+                    }
+                }
+                if (Write(file, rel)) {
+                    printf("FAIL: cannot write %s\n", file);
+                    ++failures;
+                    continue;
+                }
+
+                for (int canonicalFlag = 0; canonicalFlag <= 1;
+                                                           ++canonicalFlag) {
+                    ++cases;
+                    failures += 0 != Check(file, rel, canonicalFlag);
+                }
+            }
+        }
+    }
+    unlink(file);
+
+    printf("%d of %d systems have the original CCD.\n",
+           cases - failures, cases);
+    return failures;
+}
@@ -0,0 +1,104 @@
+#include "idep_macro_table.h"
+
+#include <assert.h>
+#include <memory.h>
+#include <string.h>
+
+#include "idep_name_array.h"
+#include "idep_name_index_map.h"
+
+enum { START_SIZE = 16, GROW_FACTOR = 2 };
+enum { NO_VALUE = -1 };
+
+namespace idep {
+
+struct MacroTableImpl {
+  NameIndexMap d_names;         // every macro defined or undefined
+  NameArray d_values;           // values of definitions, in order given
+  int* d_values_p;              // value of each macro, or NO_VALUE if
+                                // undefined
+  int d_size;                   // physical size of d_values_p
+
+  MacroTableImpl();
+  ~MacroTableImpl();
+
+  // Set the value of the macro with the specified name.
+  void set(const char* name, int length, int value);
+};
+
+MacroTableImpl::MacroTableImpl()
+    : d_size(START_SIZE) {
+  d_values_p = new int[d_size];
+}
+
+MacroTableImpl::~MacroTableImpl() {
+  delete[] d_values_p;
+}
+
+void MacroTableImpl::set(const char* name, int length, int value) {
+  const int index = d_names.Entry(name, length);
+  if (index >= d_size) {
+    int* tmp = d_values_p;
+    d_values_p = new int[d_size * GROW_FACTOR];
+    memcpy(d_values_p, tmp, d_size * sizeof *tmp);
+    d_size *= GROW_FACTOR;
+    delete[] tmp;
+  }
+  d_values_p[index] = value;
+}
+
+MacroTable::MacroTable()
+    : impl_(new MacroTableImpl) {
+}
+
+MacroTable::~MacroTable() {
+  delete impl_;
+}
+
+void MacroTable::Define(const char* definition) {
+  const char* equals = strchr(definition, '=');
+  if (equals) {
+    impl_->set(definition, equals - definition,
+               impl_->d_values.Append(equals + 1));
+  } else {
+    impl_->set(definition, strlen(definition), impl_->d_values.Append("1"));
+  }
+}
+
+void MacroTable::Undefine(const char* name) {
+  impl_->set(name, strlen(name), NO_VALUE);
+}
+
+MacroTable::State MacroTable::Lookup(const char* name,
+                                     int length,
+                                     const char** value) const {
+  const int index = impl_->d_names.GetIndexByName(name, length);
+  if (index < 0)
+    return UNKNOWN;
+  if (NO_VALUE == impl_->d_values_p[index])
+    return UNDEFINED;
+  *value = impl_->d_values[impl_->d_values_p[index]];
+  return DEFINED;
+}
+
+int MacroTable::Length() const {
+  return impl_->d_names.Length();
+}
+
+const char* MacroTable::operator[](int index) const {
+  return impl_->d_names[index];
+}
+
+std::ostream& operator<<(std::ostream& out, const MacroTable& table) {
+  for (int i = 0; i < table.Length(); ++i) {
+    const char* name = table[i];
+    const char* value;
+    if (MacroTable::DEFINED == table.Lookup(name, strlen(name), &value))
+      out << "-D" << name << '=' << value << std::endl;
+    else
+      out << "-U" << name << std::endl;
+  }
+  return out;
+}
+
+}  // namespace idep
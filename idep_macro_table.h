@@ -0,0 +1,62 @@
+#ifndef IDEP_MACRO_TABLE_H_
+#define IDEP_MACRO_TABLE_H_
+
+#include <ostream>
+
+#include "basictypes.h"
+
+namespace idep {
+
+class MacroTableImpl;
+
+// This component defines 1 fully insulated class:
+// The preprocessor macros known to be defined or undefined, as given by
+// -D and -U options, for deciding which conditionally compiled sections
+// of a file are inactive.  A macro that was neither defined nor
+// undefined here is unknown, and sections that depend on it are assumed
+// to be active.
+class MacroTable {
+ public:
+  enum State {
+    UNKNOWN = -1,       // neither defined nor undefined
+    UNDEFINED = 0,      // known to be undefined
+    DEFINED = 1         // known to be defined
+  };
+
+  MacroTable();
+  ~MacroTable();
+
+  // Define a macro as specified by a -D option: "NAME" defines NAME as
+  // 1, and "NAME=VALUE" defines NAME as VALUE.  A later definition or
+  // undefinition of the same name replaces this one.
+  void Define(const char* definition);
+
+  // Undefine the macro with the specified name, as a -U option does.
+  void Undefine(const char* name);
+
+  // Return the state of the macro whose name consists of the first
+  // |length| characters of the specified name, which need not be
+  // null-terminated at that point.  If the macro is defined, also load
+  // its value into |value|.
+  State Lookup(const char* name, int length, const char** value) const;
+
+  // Return the number of macros that are defined or undefined.
+  int Length() const;
+
+  // Return the name of the macro having the specified index in [0 ..
+  // Length() - 1], in the order first defined or undefined.
+  const char* operator[](int index) const;
+
+ private:
+  MacroTableImpl* impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(MacroTable);
+};
+
+// Print the macros of the specified table to the specified output stream
+// (out), one per line, as the -D or -U options that have the same effect.
+std::ostream& operator<<(std::ostream& out, const MacroTable& table);
+
+}  // namespace idep
+
+#endif  // IDEP_MACRO_TABLE_H_
@@ -8,30 +8,70 @@
 
 enum { START_SIZE = 1, GROW_FACTOR = 2 };
 
-static char* NewStrCpy(const char* old_str) {
-  int size = strlen(old_str) + 1;
-  char* new_str = new char[size];
-  assert(new_str);
-  memcpy(new_str, old_str, size);
-  return new_str;
-}
+// Chunks of names start small, so that short arrays stay cheap, and grow
+// up to MAX_CHUNK_SIZE bytes.  A name too long for a chunk of the current
+// size gets a chunk to itself.
+enum { MIN_CHUNK_SIZE = 1024, MAX_CHUNK_SIZE = 64 * 1024 };
+
+// Each chunk begins with a pointer to the previous chunk.
+enum { CHUNK_HEADER = sizeof(char*) };
 
 namespace idep {
 
 NameArray::NameArray(int max_entries_hint)
     : size_(max_entries_hint> 0 ? max_entries_hint: START_SIZE),
-      length_(0) {
+      length_(0),
+      chunks_(0),
+      free_(0),
+      free_size_(0),
+      chunk_size_(MIN_CHUNK_SIZE) {
   array_ = new char *[size_];
 }
 
 NameArray::~NameArray() {
-  for (int i = 0; i < length_; ++i)
-    delete [] array_[i];
+  while (chunks_) {
+    char* previous;
+    memcpy(&previous, chunks_, sizeof previous);
+    delete [] chunks_;
+    chunks_ = previous;
+  }
 
   delete [] array_;
 }
 
+char* NameArray::Intern(const char* name, int length) {
+  const int size = length + 1;
+  if (size > free_size_) {
+    const bool alone = size > chunk_size_ - CHUNK_HEADER;
+    const int chunk_size = alone ? size + CHUNK_HEADER : chunk_size_;
+    char* chunk = new char[chunk_size];
+    memcpy(chunk, &chunks_, sizeof chunks_);
+    chunks_ = chunk;
+    if (alone) {
+      // Keep the rest of the current chunk for the names that follow.
+      memcpy(chunk + CHUNK_HEADER, name, length);
+      chunk[CHUNK_HEADER + length] = '\0';
+      return chunk + CHUNK_HEADER;
+    }
+    free_ = chunk + CHUNK_HEADER;
+    free_size_ = chunk_size - CHUNK_HEADER;
+    if (chunk_size_ < MAX_CHUNK_SIZE)
+      chunk_size_ *= GROW_FACTOR;
+  }
+
+  char* copy = free_;
+  memcpy(copy, name, length);
+  copy[length] = '\0';
+  free_ += size;
+  free_size_ -= size;
+  return copy;
+}
+
 int NameArray::Append(const char* name) {
+  return Append(name, strlen(name));
+}
+
+int NameArray::Append(const char* name, int length) {
   if (length_ >= size_) {
     int oldSize = size_;
     size_ *= GROW_FACTOR;
@@ -42,7 +82,7 @@ int NameArray::Append(const char* name) {
     delete[] tmp;
   }
   assert(length_ < size_);
-  array_[length_++] = NewStrCpy(name);
+  array_[length_++] = Intern(name, length);
   return length_ - 1;
 }
 
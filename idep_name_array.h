@@ -8,7 +8,9 @@
 namespace idep {
 
 // This leaf component defines 1 class:
-// Extensible array of managed character string names.
+// Extensible array of managed character string names.  The names are
+// stored one after another in large chunks of memory that are only
+// released when the array is destroyed.
 class NameArray {
  public:
   // Create a variable length array of const character strings.
@@ -25,6 +27,11 @@ class NameArray {
   // check for repeated string values.
   int Append(const char* new_name);
 
+  // Append a copy of the first |length| characters of the specified
+  // string, which need not be null-terminated at that point, and return
+  // the value of the new index.  The copy is null-terminated.
+  int Append(const char* new_name, int length);
+
   // Return a pointer to the specified string.  Strings are stored at
   // at consecutive non-negative index locations beginning with 0 up
   // to one less than the current length.  If the index is out of range,
@@ -35,7 +42,12 @@ class NameArray {
   int Length() const;
 
  private:
-  // Array of dynamically allocated character strings.
+  // Copy the specified string, of the specified length, into the current
+  // chunk of memory, first starting a new chunk if it does not fit, and
+  // return the copy.
+  char* Intern(const char* name, int length);
+
+  // Array of pointers to the names in the chunks below.
   char** array_;
 
   // Physical size of array.
@@ -44,6 +56,17 @@ class NameArray {
   // Logical size of array.
   int length_;
 
+  // Most recently allocated chunk of names, or 0.  Each chunk begins
+  // with a pointer to the chunk allocated before it.
+  char* chunks_;
+
+  // Free space at the end of the current chunk.
+  char* free_;
+  int free_size_;
+
+  // Size of the next chunk to be allocated.
+  int chunk_size_;
+
   DISALLOW_COPY_AND_ASSIGN(NameArray);
 };
 
@@ -2,97 +2,360 @@
 
 #include <assert.h>
 #include <memory.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
 
 #include "idep_name_array.h"
 
-enum { DEFAULT_TABLE_SIZE = 521 };
+// IMPLEMENTATION NOTE: The names themselves live in a NameArray, in order
+// of index.  The hash table is open-addressed with Robin Hood insertion:
+// each slot holds the index of a name along with its hash, and a name
+// being placed displaces any name that is closer to its home slot (the
+// slot its hash selects).  Probe sequences thus stay short and even, and
+// a search can stop as soon as it meets a name closer to home than the
+// name sought would be.  Names are only compared once their hashes are
+// equal.  The table doubles whenever it becomes 7/8 full.
+//
+// Freeze() adds a perfect hash over the current names, built by
+// "hash and displace": each name hashes (with a second, 64-bit function)
+// to one of about Length() / BUCKET_SIZE buckets, and each bucket is given
+// a pilot value that, mixed into the hashes of its names, sends them all
+// to distinct free slots of a table with 1/SPARE_FRACTION more slots than
+// names.  Buckets are placed largest first, while the table is still
+// mostly empty, and the spare slots spare the last ones a long search.  A
+// lookup then computes one hash, reads its bucket's pilot and its slot,
+// and compares one name, unless the slot's copy of the upper half of the
+// hash already rules the name out.  Names are never removed, so the index
+// stays valid until a name is added.
+
+enum { DEFAULT_TABLE_SIZE = 512 };      // must be a power of 2
+enum { MAX_LOAD_NUMERATOR = 7, MAX_LOAD_DENOMINATOR = 8, GROW_FACTOR = 2 };
 enum { BAD_INDEX = -1 };
+enum { EMPTY = 0 };                     // hash of an empty slot
+enum { BUCKET_SIZE = 4 };               // average names per frozen bucket
+enum { SPARE_FRACTION = 16 };           // 1/16 of frozen slots are spare
+enum { MAX_PILOT = 1 << 20 };           // give up on freezing beyond this
+enum { FREE = -1 };                     // frozen slot never assigned
 
-static unsigned hash(register const char* name) {
-  register unsigned sum = 1000003; // 1,000,003 is the 78,498th prime number
-  while (*name) {
-    sum *= *name++; // integer multiplication is a subroutine on a SPARC
+static unsigned hash(register const char* name, int length) {
+  // FNV-1a, followed by the final mix of MurmurHash3 so that the low
+  // bits (which select the slot) depend on every character.
+  register unsigned h = 2166136261u;
+  for (register const char* end = name + length; name < end; ++name) {
+    h ^= static_cast<unsigned char>(*name);
+    h *= 16777619u;
   }
-  return sum; // unsigned ensures positive value for use with (%) operator.
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return EMPTY == h ? 1 : h;  // never the hash of an empty slot
 }
 
-namespace idep {
+static uint64_t hash64(register const char* name, int length) {
+  // 64-bit FNV-1a, followed by the final mix of MurmurHash3.  Distinct
+  // names all but never collide, as the frozen index requires.
+  register uint64_t h = 14695981039346656037ULL;
+  for (register const char* end = name + length; name < end; ++name) {
+    h ^= static_cast<unsigned char>(*name);
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
 
-struct NameIndexMapLink {
-  const char* name_;
-  int index_;                  // index of name
-  NameIndexMapLink* next_;  // pointer to next link
+static unsigned frozenCheck(uint64_t h) {
+  return static_cast<unsigned>(h >> 32);
+}
 
-  NameIndexMapLink(const char* name,
-                   int index,
-                   NameIndexMapLink* next);
-};
+static int frozenBucket(uint64_t h, int num_buckets) {
+  return frozenCheck(h) % num_buckets;
+}
 
-NameIndexMapLink::NameIndexMapLink(const char* name,
-                                   int index,
-                                   NameIndexMapLink* next)
-    : name_(name),
-      index_(index),
-      next_(next) {
+static int frozenSlot(uint64_t h, unsigned pilot, int num_slots) {
+  register unsigned p = pilot * 0x9e3779b9u + 0x7f4a7c15u;
+  p ^= p >> 16;
+  p *= 0x85ebca6bu;
+  p ^= p >> 13;
+  return (static_cast<unsigned>(h) ^ p) % num_slots;
 }
 
-static const NameIndexMapLink* find(const NameIndexMapLink* p,
-                                    const char* name) {
-  while (p && 0 != strcmp(p->name_, name))
-    p = p->next_;
-  return p;
+static bool equal(const char* candidate, const char* name, int length) {
+  return 0 == strncmp(candidate, name, length) && '\0' == candidate[length];
 }
 
+namespace idep {
+
+struct FrozenSlot {
+    const char* name_;          // name in this slot
+    int index_;                 // index of that name
+    unsigned check_;            // frozenCheck() of the name's hash
+};
+
 struct NameIndexMapImpl {
     NameArray array_;
-    NameIndexMapLink** table_;  // hash table of names
-    int table_size_;            // size of hash table
+    unsigned* hashes_;          // hash of the name in each slot, or EMPTY
+    int* indices_;              // index of the name in each slot
+    int mask_;                  // number of slots - 1
+
+    // The frozen index, if any (see Freeze()).
+    unsigned* pilots_;          // pilot of each bucket, or 0 if not frozen
+    FrozenSlot* slots_;         // name in each frozen slot
+    int num_buckets_;
+    int num_slots_;
 
     // Create a map representation assuming the specified (max) size.
     NameIndexMapImpl(int size);
 
     ~NameIndexMapImpl();
 
-    // Find the appropriate slot for this name.
-    NameIndexMapLink *& findSlot(const char* name);
+    // Return the index of the name of the specified length having the
+    // specified hash, or BAD_INDEX if it is not present.
+    int find(const char* name, int length, unsigned h) const;
+
+    // Append the name of the specified length having the specified hash
+    // and return its index.
+    int insert(const char* name, int length, unsigned h);
+
+    // Put the specified index in the table, which must not be full.
+    void place(unsigned h, int index);
+
+    // Double the number of slots.
+    void grow();
+
+    // Rehash the names into the specified number of slots, which must be
+    // a power of 2 large enough to hold them.
+    void rehash(int slots);
+
+    // Build the frozen index; return false, leaving this map unfrozen, if
+    // no pilot can be found for some bucket.
+    bool freeze();
 
-    // Insert name into specified slot.
-    int insert(NameIndexMapLink *& slot, const char* name);
+    // Discard the frozen index, if any.
+    void thaw();
+
+    // Return the index of the name of the specified length using the
+    // frozen index, or BAD_INDEX if it is not present.
+    int findFrozen(const char* name, int length) const;
 };
 
 NameIndexMapImpl::NameIndexMapImpl(int size)
     : array_(size),
-      table_size_(size > 0 ? size : DEFAULT_TABLE_SIZE) {
-    table_ = new NameIndexMapLink *[table_size_];
-    assert(table_);
-    memset(table_, 0, table_size_ * sizeof *table_);
+      pilots_(0),
+      slots_(0),
+      num_buckets_(0),
+      num_slots_(0) {
+  int slots = DEFAULT_TABLE_SIZE;
+  while (slots / MAX_LOAD_DENOMINATOR * MAX_LOAD_NUMERATOR < size)
+    slots *= GROW_FACTOR;
+  mask_ = slots - 1;
+  hashes_ = new unsigned[slots];
+  indices_ = new int[slots];
+  memset(hashes_, EMPTY, slots * sizeof *hashes_);
 }
 
 NameIndexMapImpl::~NameIndexMapImpl() {
-  for (int i = 0; i < table_size_; ++i) {
-    NameIndexMapLink* p = table_[i];
-    while (p) {
-      NameIndexMapLink* q = p;
-      p = p->next_;
-      delete q;
+  delete[] hashes_;
+  delete[] indices_;
+  thaw();
+}
+
+int NameIndexMapImpl::find(const char* name, int length, unsigned h) const {
+  for (int i = h & mask_, distance = 0; ; i = (i + 1) & mask_, ++distance) {
+    const unsigned slot_hash = hashes_[i];
+    if (EMPTY == slot_hash)
+      return BAD_INDEX;
+    if (((i - slot_hash) & mask_) < static_cast<unsigned>(distance))
+      return BAD_INDEX;         // name would have displaced this one
+    if (slot_hash == h && equal(array_[indices_[i]], name, length))
+      return indices_[i];
+  }
+}
+
+int NameIndexMapImpl::insert(const char* name, int length, unsigned h) {
+  if (pilots_)
+    thaw();                     // the frozen index lacks the new name
+  const int slots = mask_ + 1;
+  if (array_.Length() + 1 > slots / MAX_LOAD_DENOMINATOR * MAX_LOAD_NUMERATOR)
+    grow();
+  int index = array_.Append(name, length); // index into managed strings
+  place(h, index);
+  return index;
+}
+
+void NameIndexMapImpl::place(unsigned h, int index) {
+  for (int i = h & mask_, distance = 0; ; i = (i + 1) & mask_, ++distance) {
+    if (EMPTY == hashes_[i]) {
+      hashes_[i] = h;
+      indices_[i] = index;
+      return;
+    }
+    const int slot_distance = (i - hashes_[i]) & mask_;
+    if (slot_distance < distance) {     // rob the rich: swap and carry on
+      unsigned tmp_hash = hashes_[i];
+      int tmp_index = indices_[i];
+      hashes_[i] = h;
+      indices_[i] = index;
+      h = tmp_hash;
+      index = tmp_index;
+      distance = slot_distance;
     }
   }
-  delete[] table_;
 }
 
-NameIndexMapLink *& NameIndexMapImpl::findSlot(const char* name) {
-  int index = hash(name) % table_size_;
-  assert(index >= 0 && index < table_size_);
-  return table_[index];
+void NameIndexMapImpl::grow() {
+  rehash((mask_ + 1) * GROW_FACTOR);
 }
 
-int NameIndexMapImpl::insert(NameIndexMapLink *& slot, const char* nm) {
-  int index = array_.Append(nm); // index is into a managed string array
-  slot = new NameIndexMapLink(array_[index], index, slot);
-  return index;
+void NameIndexMapImpl::rehash(int slots) {
+  const int old_slots = mask_ + 1;
+  unsigned* old_hashes = hashes_;
+  int* old_indices = indices_;
+
+  mask_ = slots - 1;
+  hashes_ = new unsigned[slots];
+  indices_ = new int[slots];
+  memset(hashes_, EMPTY, slots * sizeof *hashes_);
+
+  for (int i = 0; i < old_slots; ++i) {
+    if (EMPTY != old_hashes[i])
+      place(old_hashes[i], old_indices[i]);
+  }
+
+  delete[] old_hashes;
+  delete[] old_indices;
+}
+
+// Orders buckets by decreasing size, then by increasing number.
+class LargerBucket {
+ public:
+  explicit LargerBucket(const int* start) : start_(start) {
+  }
+
+  bool operator()(int a, int b) const {
+    const int size_a = start_[a + 1] - start_[a];
+    const int size_b = start_[b + 1] - start_[b];
+    return size_a != size_b ? size_a > size_b : a < b;
+  }
+
+ private:
+  const int* start_;
+};
+
+bool NameIndexMapImpl::freeze() {
+  thaw();
+
+  const int n = array_.Length();
+  if (0 == n)
+    return false;               // nothing to index
+  const int r = (n + BUCKET_SIZE - 1) / BUCKET_SIZE;
+
+  uint64_t* keys = new uint64_t[n];
+  for (int i = 0; i < n; ++i)
+    keys[i] = hash64(array_[i], strlen(array_[i]));
+
+  // Group the names by bucket (a counting sort).
+  int* start = new int[r + 1];
+  memset(start, 0, (r + 1) * sizeof *start);
+  for (int i = 0; i < n; ++i)
+    ++start[frozenBucket(keys[i], r) + 1];
+  for (int b = 0; b < r; ++b)
+    start[b + 1] += start[b];
+  int* members = new int[n];
+  int* cursor = new int[r];
+  memcpy(cursor, start, r * sizeof *cursor);
+  for (int i = 0; i < n; ++i)
+    members[cursor[frozenBucket(keys[i], r)]++] = i;
+  delete[] cursor;
+
+  int* order = new int[r];
+  for (int b = 0; b < r; ++b)
+    order[b] = b;
+  std::sort(order, order + r, LargerBucket(start));
+
+  pilots_ = new unsigned[r];
+  memset(pilots_, 0, r * sizeof *pilots_);
+  const int m = n + n / SPARE_FRACTION + 1;
+  slots_ = new FrozenSlot[m];
+  for (int i = 0; i < m; ++i) {
+    slots_[i].name_ = "";
+    slots_[i].index_ = FREE;
+    slots_[i].check_ = 0;
+  }
+  num_buckets_ = r;
+  num_slots_ = m;
+
+  // Even the last buckets placed need only tens of tries to find free
+  // slots; exhausting MAX_PILOT means that two names share a key.
+  int* positions = new int[n];
+  bool success = true;
+  for (int o = 0; success && o < r; ++o) {
+    const int b = order[o];
+    const int size = start[b + 1] - start[b];
+    if (0 == size)
+      break;                    // the rest are empty too
+    const int* bucket = members + start[b];
+    for (unsigned pilot = 0; ; ++pilot) {
+      if (pilot > MAX_PILOT) {
+        success = false;
+        break;
+      }
+      int j = 0;
+      for (; j < size; ++j) {
+        const int p = frozenSlot(keys[bucket[j]], pilot, m);
+        if (FREE != slots_[p].index_ ||
+            positions + j != std::find(positions, positions + j, p))
+          break;
+        positions[j] = p;
+      }
+      if (j == size) {
+        for (j = 0; j < size; ++j) {
+          FrozenSlot& slot = slots_[positions[j]];
+          slot.name_ = array_[bucket[j]];
+          slot.index_ = bucket[j];
+          slot.check_ = frozenCheck(keys[bucket[j]]);
+        }
+        pilots_[b] = pilot;
+        break;
+      }
+    }
+  }
+
+  delete[] positions;
+  delete[] order;
+  delete[] members;
+  delete[] start;
+  delete[] keys;
+
+  if (!success)
+    thaw();
+  return success;
+}
+
+void NameIndexMapImpl::thaw() {
+  delete[] pilots_;
+  delete[] slots_;
+  pilots_ = 0;
+  slots_ = 0;
+  num_buckets_ = 0;
+  num_slots_ = 0;
+}
+
+int NameIndexMapImpl::findFrozen(const char* name, int length) const {
+  const uint64_t h = hash64(name, length);
+  const unsigned pilot = pilots_[frozenBucket(h, num_buckets_)];
+  const FrozenSlot& slot = slots_[frozenSlot(h, pilot, num_slots_)];
+  if (slot.check_ != frozenCheck(h) || !equal(slot.name_, name, length))
+    return BAD_INDEX;
+  return slot.index_;
 }
 
 NameIndexMap::NameIndexMap(int max_entries_hint)
@@ -104,14 +367,31 @@ NameIndexMap::~NameIndexMap() {
 }
 
 int NameIndexMap::Add(const char* name) {
-  NameIndexMapLink *& slot = impl_->findSlot(name);
-  return find(slot, name) ? BAD_INDEX : impl_->insert(slot, name);
+  return Add(name, strlen(name));
+}
+
+int NameIndexMap::Add(const char* name, int length) {
+  unsigned h = hash(name, length);
+  return impl_->find(name, length, h) >= 0 ? BAD_INDEX
+                                           : impl_->insert(name, length, h);
 }
 
 int NameIndexMap::Entry(const char* name) {
-  NameIndexMapLink *& slot = impl_->findSlot(name);
-  const NameIndexMapLink* link = find(slot, name);
-  return link ? link->index_ : impl_->insert(slot, name);
+  return Entry(name, strlen(name));
+}
+
+int NameIndexMap::Entry(const char* name, int length) {
+  unsigned h = hash(name, length);
+  int index = impl_->find(name, length, h);
+  return index >= 0 ? index : impl_->insert(name, length, h);
+}
+
+void NameIndexMap::Reserve(int num_entries) {
+  int slots = impl_->mask_ + 1;
+  while (slots / MAX_LOAD_DENOMINATOR * MAX_LOAD_NUMERATOR < num_entries)
+    slots *= GROW_FACTOR;
+  if (slots > impl_->mask_ + 1)
+    impl_->rehash(slots);
 }
 
 const char* NameIndexMap::operator[](int index) const {
@@ -123,9 +403,22 @@ int NameIndexMap::Length() const {
 }
 
 int NameIndexMap::GetIndexByName(const char* name) const {
-  NameIndexMapLink*& slot = impl_->findSlot(name);
-  const NameIndexMapLink* link = find(slot, name);
-  return link ? link->index_ : BAD_INDEX;
+  return GetIndexByName(name, strlen(name));
+}
+
+int NameIndexMap::GetIndexByName(const char* name, int length) const {
+  if (impl_->pilots_)
+    return impl_->findFrozen(name, length);
+  return impl_->find(name, length, hash(name, length));
+}
+
+void NameIndexMap::Freeze() {
+  if (!impl_->pilots_)
+    impl_->freeze();
+}
+
+int NameIndexMap::IsFrozen() const {
+  return 0 != impl_->pilots_;
 }
 
 std::ostream& operator<<(std::ostream& out, const NameIndexMap& map) {
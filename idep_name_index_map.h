@@ -14,7 +14,8 @@ class NameIndexMapImpl;
 class NameIndexMap {
  public:
   // Create a new mapping; optionally specify the expected number of
-  // entires.  By default, a moderately large hash table will be created.
+  // entires.  By default, a moderately large hash table will be created;
+  // in any case the table grows as needed to keep lookups fast.
   explicit NameIndexMap(int max_entries_hint = 0);
   ~NameIndexMap();
 
@@ -22,11 +23,23 @@ class NameIndexMap {
   // not already present; otherwise return -1.
   int Add(const char* name);
 
+  // Same as Add(name) for the first |length| characters of the specified
+  // name, which need not be null-terminated at that point.
+  int Add(const char* name, int length);
+
   // Add a name to the table if necessary; always return a valid index.
   // Note: entry() is usually more efficient than GetIndexByName() followed by
   // an occasional Add().
   int Entry(const char* name);
 
+  // Same as Entry(name) for the first |length| characters of the
+  // specified name, which need not be null-terminated at that point.
+  int Entry(const char* name, int length);
+
+  // Make room for at least the specified number of names in all, so that
+  // adding that many does not need to grow the table.
+  void Reserve(int num_entries);
+
   // Return the name associated with the specified index or 0 if the
   // specified index is out of the range [0 .. N], where N = length - 1.
   const char* operator[](int index) const;
@@ -37,6 +50,21 @@ class NameIndexMap {
   // Return the index of the specified name, or -1 if not found.
   int GetIndexByName(const char* name) const;
 
+  // Same as GetIndexByName(name) for the first |length| characters of the
+  // specified name, which need not be null-terminated at that point.
+  int GetIndexByName(const char* name, int length) const;
+
+  // Build a read-only index over the names now in this mapping, after
+  // which GetIndexByName() looks a name up with a single probe of a
+  // perfect hash table and one comparison.  The mapping remains
+  // extensible: adding a name discards the index, and lookups fall back
+  // to the ordinary table until Freeze() is called again.  Freezing a
+  // frozen mapping has no effect.
+  void Freeze();
+
+  // Return 1 if the read-only index is in effect; else 0.
+  int IsFrozen() const;
+
  private:
   NameIndexMapImpl* impl_;
 
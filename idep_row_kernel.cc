@@ -0,0 +1,218 @@
+#include "idep_row_kernel.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IDEP_ROW_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+// IMPLEMENTATION NOTE: The vector kernels are compiled with per-function
+// target attributes so that this file needs no special compiler flags;
+// they are only ever called after cpuid has confirmed that the processor
+// supports the corresponding instruction set.  Rows are not required to
+// be aligned, and any words left over after the last full vector are
+// handled one word at a time.
+
+namespace {
+
+typedef idep::RowKernel::Word Word;
+typedef void (*RowOp)(Word* dst, const Word* src, int words);
+
+void OrScalar(Word* dst, const Word* src, int words) {
+  for (int i = 0; i < words; ++i)
+    dst[i] |= src[i];
+}
+
+void AndNotScalar(Word* dst, const Word* src, int words) {
+  for (int i = 0; i < words; ++i)
+    dst[i] &= ~src[i];
+}
+
+#if IDEP_ROW_KERNEL_X86
+
+__attribute__((target("sse2")))
+void OrSse2(Word* dst, const Word* src, int words) {
+  int i = 0;
+  for (; i + 2 <= words; i += 2) {
+    __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+    const __m128i* s = reinterpret_cast<const __m128i*>(src + i);
+    _mm_storeu_si128(d, _mm_or_si128(_mm_loadu_si128(d), _mm_loadu_si128(s)));
+  }
+  OrScalar(dst + i, src + i, words - i);
+}
+
+__attribute__((target("sse2")))
+void AndNotSse2(Word* dst, const Word* src, int words) {
+  int i = 0;
+  for (; i + 2 <= words; i += 2) {
+    __m128i* d = reinterpret_cast<__m128i*>(dst + i);
+    const __m128i* s = reinterpret_cast<const __m128i*>(src + i);
+    // _mm_andnot_si128(a, b) computes ~a & b.
+    _mm_storeu_si128(d, _mm_andnot_si128(_mm_loadu_si128(s),
+                                         _mm_loadu_si128(d)));
+  }
+  AndNotScalar(dst + i, src + i, words - i);
+}
+
+__attribute__((target("avx2")))
+void OrAvx2(Word* dst, const Word* src, int words) {
+  int i = 0;
+  for (; i + 4 <= words; i += 4) {
+    __m256i* d = reinterpret_cast<__m256i*>(dst + i);
+    const __m256i* s = reinterpret_cast<const __m256i*>(src + i);
+    _mm256_storeu_si256(d, _mm256_or_si256(_mm256_loadu_si256(d),
+                                           _mm256_loadu_si256(s)));
+  }
+  OrScalar(dst + i, src + i, words - i);
+}
+
+__attribute__((target("avx2")))
+void AndNotAvx2(Word* dst, const Word* src, int words) {
+  int i = 0;
+  for (; i + 4 <= words; i += 4) {
+    __m256i* d = reinterpret_cast<__m256i*>(dst + i);
+    const __m256i* s = reinterpret_cast<const __m256i*>(src + i);
+    _mm256_storeu_si256(d, _mm256_andnot_si256(_mm256_loadu_si256(s),
+                                               _mm256_loadu_si256(d)));
+  }
+  AndNotScalar(dst + i, src + i, words - i);
+}
+
+__attribute__((target("avx512f")))
+void OrAvx512(Word* dst, const Word* src, int words) {
+  int i = 0;
+  for (; i + 8 <= words; i += 8) {
+    __m512i d = _mm512_loadu_si512(dst + i);
+    __m512i s = _mm512_loadu_si512(src + i);
+    _mm512_storeu_si512(dst + i, _mm512_or_si512(d, s));
+  }
+  OrScalar(dst + i, src + i, words - i);
+}
+
+__attribute__((target("avx512f")))
+void AndNotAvx512(Word* dst, const Word* src, int words) {
+  int i = 0;
+  for (; i + 8 <= words; i += 8) {
+    __m512i d = _mm512_loadu_si512(dst + i);
+    __m512i s = _mm512_loadu_si512(src + i);
+    // The unmasked andnot intrinsics merge into an undefined register,
+    // which some compilers flag as uninitialized; a full mask is the same
+    // instruction without that.
+    _mm512_storeu_si512(dst + i, _mm512_maskz_andnot_epi64(0xFF, s, d));
+  }
+  AndNotScalar(dst + i, src + i, words - i);
+}
+
+#endif  // IDEP_ROW_KERNEL_X86
+
+struct KernelEntry {
+  const char* name;
+  RowOp or_op;
+  RowOp and_not_op;
+};
+
+const KernelEntry kKernels[idep::RowKernel::NUM_KINDS] = {
+  { "auto",   0,            0                },
+  { "scalar", OrScalar,     AndNotScalar     },
+#if IDEP_ROW_KERNEL_X86
+  { "sse2",   OrSse2,       AndNotSse2       },
+  { "avx2",   OrAvx2,       AndNotAvx2       },
+  { "avx512", OrAvx512,     AndNotAvx512     },
+#else
+  { "sse2",   0,            0                },
+  { "avx2",   0,            0                },
+  { "avx512", 0,            0                },
+#endif
+};
+
+void ResolveOr(Word* dst, const Word* src, int words);
+void ResolveAndNot(Word* dst, const Word* src, int words);
+
+// Until a kernel is selected, the entry points resolve to the best
+// available kernel on first use.
+idep::RowKernel::Kind s_current = idep::RowKernel::AUTO;
+RowOp s_or = ResolveOr;
+RowOp s_and_not = ResolveAndNot;
+
+void ResolveOr(Word* dst, const Word* src, int words) {
+  idep::RowKernel::Select(idep::RowKernel::AUTO);
+  s_or(dst, src, words);
+}
+
+void ResolveAndNot(Word* dst, const Word* src, int words) {
+  idep::RowKernel::Select(idep::RowKernel::AUTO);
+  s_and_not(dst, src, words);
+}
+
+}  // namespace
+
+namespace idep {
+
+void RowKernel::Or(Word* dst, const Word* src, int words) {
+  s_or(dst, src, words);
+}
+
+void RowKernel::AndNot(Word* dst, const Word* src, int words) {
+  s_and_not(dst, src, words);
+}
+
+bool RowKernel::IsSupported(Kind kind) {
+  switch (kind) {
+    case AUTO:
+    case SCALAR:
+      return true;
+#if IDEP_ROW_KERNEL_X86
+    case SSE2:
+      return __builtin_cpu_supports("sse2");
+    case AVX2:
+      return __builtin_cpu_supports("avx2");
+    case AVX512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+bool RowKernel::Select(Kind kind) {
+  if (kind < 0 || kind >= NUM_KINDS || !IsSupported(kind))
+    return false;
+
+  if (AUTO == kind) {
+    kind = SCALAR;
+    for (int k = NUM_KINDS - 1; k > SCALAR; --k) {
+      if (IsSupported(static_cast<Kind>(k))) {
+        kind = static_cast<Kind>(k);
+        break;
+      }
+    }
+  }
+
+  assert(kKernels[kind].or_op && kKernels[kind].and_not_op);
+  s_current = kind;
+  s_or = kKernels[kind].or_op;
+  s_and_not = kKernels[kind].and_not_op;
+  return true;
+}
+
+bool RowKernel::Select(const char* name) {
+  for (int k = 0; k < NUM_KINDS; ++k) {
+    if (0 == strcmp(name, kKernels[k].name))
+      return Select(static_cast<Kind>(k));
+  }
+  return false;
+}
+
+RowKernel::Kind RowKernel::Current() {
+  if (AUTO == s_current)
+    Select(AUTO);
+  return s_current;
+}
+
+const char* RowKernel::Name(Kind kind) {
+  return kind >= 0 && kind < NUM_KINDS ? kKernels[kind].name : 0;
+}
+
+}  // namespace idep
@@ -0,0 +1,54 @@
+#ifndef IDEP_ROW_KERNEL_H_
+#define IDEP_ROW_KERNEL_H_
+
+#include <stdint.h>
+
+namespace idep {
+
+// This leaf component defines 1 utility class:
+// Word-parallel operations on rows of packed bits.  Each operation is
+// carried out by one of several kernels (scalar, SSE2, AVX2, AVX-512);
+// by default the widest kernel supported by the processor is chosen at
+// run time via cpuid.
+class RowKernel {
+ public:
+  typedef uint64_t Word;
+
+  enum Kind {
+    AUTO,         // widest kernel supported by this processor
+    SCALAR,       // portable 64-bit word loop
+    SSE2,         // 128-bit vectors
+    AVX2,         // 256-bit vectors
+    AVX512,       // 512-bit vectors
+    NUM_KINDS     // must be last entry
+  };
+
+  // Set dst[i] |= src[i] for each i in [0 .. words - 1].
+  static void Or(Word* dst, const Word* src, int words);
+
+  // Set dst[i] &= ~src[i] for each i in [0 .. words - 1].
+  static void AndNot(Word* dst, const Word* src, int words);
+
+  // Use the specified kernel for all subsequent operations.  Return true
+  // on success, and false (leaving the current selection unchanged) if
+  // this processor does not support that kernel.
+  static bool Select(Kind kind);
+
+  // Same as above, but the kernel is identified by its name ("auto",
+  // "scalar", "sse2", "avx2" or "avx512").  Return false if the name is
+  // unknown or the kernel is not supported.
+  static bool Select(const char* name);
+
+  // Return true if this processor can run the specified kernel.
+  static bool IsSupported(Kind kind);
+
+  // Return the kernel currently in use (never AUTO).
+  static Kind Current();
+
+  // Return the name of the specified kernel.
+  static const char* Name(Kind kind);
+};
+
+}  // namespace idep
+
+#endif  // IDEP_ROW_KERNEL_H_
@@ -0,0 +1,551 @@
+#include "idep_scan_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <memory.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "idep_file_dep_iterator.h"
+#include "idep_name_array.h"
+#include "idep_name_index_map.h"
+
+// IMPLEMENTATION NOTE: A cache file consists of, in this order:
+//
+//   CacheHeader    magic, version, byte order and the numbers below
+//   CacheEntry[]   one per file and configuration
+//   uint32_t[]     slots of a hash table of the entries by configuration
+//                  and path: 1 + entry, or 0 if empty; the number of
+//                  slots is a power of 2, and at most half are in use
+//   uint32_t[]     the names of all entries, entry by entry, as offsets
+//                  of strings
+//   char[]         null-terminated strings (paths, configurations and
+//                  names), each distinct string stored once
+//
+// All numbers are in the byte order of the machine that wrote the file;
+// a file written by another kind of machine is invalid.  Load() checks
+// every count and offset once, so that the mapped file can be used from
+// then on without further checks.  Entries added later are kept in
+// ordinary memory; Save() merges the two and writes a new file under a
+// temporary name, which is then renamed over the old one.  A loaded
+// entry is carried over only if its file still has the same identity,
+// so that the file never holds more than one entry per existing file
+// and configuration.
+
+enum { MAGIC_LENGTH = 8, VERSION = 1, BYTE_ORDER_MARK = 0x01020304 };
+enum { NO_ENTRY = -1 };
+enum { START_SIZE = 16, GROW_FACTOR = 2, MIN_SLOTS = 16 };
+enum { RACY_SECONDS = 2 };              // a file modified less than this
+                                        // long ago may change unnoticed
+static const char kMagic[MAGIC_LENGTH + 1] = "IDEPSCAN";
+
+struct CacheHeader {
+  char magic_[MAGIC_LENGTH];
+  uint32_t version_;
+  uint32_t byte_order_;
+  uint32_t num_entries_;
+  uint32_t num_slots_;
+  uint32_t num_names_;
+  uint32_t strings_length_;
+};
+
+struct CacheEntry {
+  uint64_t device_;
+  uint64_t inode_;
+  int64_t size_;
+  int64_t mtime_sec_;
+  int64_t mtime_nsec_;
+  uint32_t path_;               // offset of the path
+  uint32_t configuration_;      // offset of the configuration
+  uint32_t first_name_;         // index of the first name of this entry
+  uint32_t num_names_;
+  int32_t num_skipped_;
+  uint32_t hash_;               // of the configuration and the path
+};
+
+static unsigned hashOf(unsigned h, const char* s) {
+  // Continue the specified FNV-1a hash with the specified string and its
+  // terminating null character.
+  do {
+    h ^= static_cast<unsigned char>(*s);
+    h *= 16777619u;
+  } while (*s++);
+  return h;
+}
+
+static void setIdentity(CacheEntry* entry, const struct stat& status) {
+  entry->device_ = status.st_dev;
+  entry->inode_ = status.st_ino;
+  entry->size_ = status.st_size;
+  entry->mtime_sec_ = status.st_mtim.tv_sec;
+  entry->mtime_nsec_ = status.st_mtim.tv_nsec;
+}
+
+static bool hasIdentity(const CacheEntry& entry, const struct stat& status) {
+  return entry.device_ == static_cast<uint64_t>(status.st_dev) &&
+         entry.inode_ == static_cast<uint64_t>(status.st_ino) &&
+         entry.size_ == status.st_size &&
+         entry.mtime_sec_ == status.st_mtim.tv_sec &&
+         entry.mtime_nsec_ == status.st_mtim.tv_nsec;
+}
+
+template <typename T> static T* resize(T* array, int length, int size) {
+  T* tmp = new T[size];
+  memcpy(tmp, array, length * sizeof *tmp);
+  delete[] array;
+  return tmp;
+}
+
+namespace {
+
+// The strings of a cache file being written, each stored once.
+class StringPool {
+ public:
+  StringPool() : offsets_(new uint32_t[START_SIZE]), size_(START_SIZE) {}
+  ~StringPool() { delete[] offsets_; }
+
+  // Return the offset of the specified string, adding it if needed.
+  uint32_t Offset(const char* s) {
+    const int length = strings_.Length();
+    const int index = strings_.Entry(s);
+    if (strings_.Length() > length) {
+      if (index >= size_) {
+        offsets_ = resize(offsets_, length, size_ * GROW_FACTOR);
+        size_ *= GROW_FACTOR;
+      }
+      offsets_[index] = pool_.size();
+      pool_.append(s, strlen(s) + 1);
+    }
+    return offsets_[index];
+  }
+
+  const std::string& Pool() const { return pool_; }
+
+ private:
+  idep::NameIndexMap strings_;
+  uint32_t* offsets_;           // offset of each string in pool_
+  int size_;                    // physical size of offsets_
+  std::string pool_;
+};
+
+bool writeAll(int fd, const void* data, size_t length) {
+  const char* p = static_cast<const char*>(data);
+  while (length > 0) {
+    const ssize_t n = write(fd, p, length);
+    if (n < 0 && EINTR == errno)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    length -= n;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace idep {
+
+struct AddedEntry {
+  CacheEntry entry_;            // names index added_names_
+  bool save_;                   // whether to save this entry
+};
+
+struct ScanCacheImpl {
+  std::string configuration_;
+  unsigned hash_;               // hash of configuration_ alone
+  time_t racy_time_;            // files modified after this are not saved
+
+  void* map_;                   // the cache file loaded, or 0
+  size_t map_size_;
+  const CacheHeader* header_;
+  const CacheEntry* entries_;
+  const uint32_t* slots_;
+  const uint32_t* names_;
+  const char* strings_;
+  int num_loaded_;              // number of entries in entries_
+
+  NameIndexMap added_paths_;    // path of each entry added
+  AddedEntry* added_;
+  int added_size_;              // physical size of added_
+  NameArray added_names_;       // names of the entries added
+  bool dirty_;                  // whether an entry to save was added
+
+  explicit ScanCacheImpl(const char* configuration);
+  ~ScanCacheImpl();
+
+  // Unmap the cache file loaded, if any.
+  void unload();
+
+  // Return whether the mapped file is a valid cache file.
+  bool check() const;
+
+  // Return the loaded entry of the specified path, or NO_ENTRY.
+  int findLoaded(const char* path) const;
+};
+
+ScanCacheImpl::ScanCacheImpl(const char* configuration)
+    : configuration_(configuration),
+      hash_(hashOf(2166136261u, configuration)),
+      racy_time_(time(0) - RACY_SECONDS),
+      map_(0),
+      map_size_(0),
+      num_loaded_(0),
+      added_(new AddedEntry[START_SIZE]),
+      added_size_(START_SIZE),
+      dirty_(false) {
+}
+
+ScanCacheImpl::~ScanCacheImpl() {
+  unload();
+  delete[] added_;
+}
+
+void ScanCacheImpl::unload() {
+  if (map_)
+    munmap(map_, map_size_);
+  map_ = 0;
+  num_loaded_ = 0;
+}
+
+bool ScanCacheImpl::check() const {
+  if (map_size_ < sizeof *header_ ||
+      0 != memcmp(header_->magic_, kMagic, MAGIC_LENGTH) ||
+      VERSION != header_->version_ ||
+      BYTE_ORDER_MARK != header_->byte_order_)
+    return false;
+
+  const uint64_t num_entries = header_->num_entries_;
+  const uint64_t num_slots = header_->num_slots_;
+  const uint64_t num_names = header_->num_names_;
+  const uint64_t strings_length = header_->strings_length_;
+  if (num_slots <= num_entries || 0 != (num_slots & (num_slots - 1)) ||
+      map_size_ != sizeof *header_ + num_entries * sizeof *entries_ +
+                   (num_slots + num_names) * sizeof(uint32_t) +
+                   strings_length ||
+      0 == strings_length || '\0' != strings_[strings_length - 1])
+    return false;
+
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    const CacheEntry& e = entries_[i];
+    if (e.path_ >= strings_length || e.configuration_ >= strings_length ||
+        static_cast<uint64_t>(e.first_name_) + e.num_names_ > num_names)
+      return false;
+  }
+  for (uint64_t i = 0; i < num_slots; ++i) {
+    if (slots_[i] > num_entries)
+      return false;
+  }
+  for (uint64_t i = 0; i < num_names; ++i) {
+    if (names_[i] >= strings_length)
+      return false;
+  }
+  return true;
+}
+
+int ScanCacheImpl::findLoaded(const char* path) const {
+  if (!map_)
+    return NO_ENTRY;
+  const unsigned h = hashOf(hash_, path);
+  const unsigned mask = header_->num_slots_ - 1;
+  for (unsigned i = h & mask; ; i = (i + 1) & mask) {
+    if (0 == slots_[i])
+      return NO_ENTRY;
+    const int entry = slots_[i] - 1;
+    const CacheEntry& e = entries_[entry];
+    if (h == e.hash_ && 0 == strcmp(strings_ + e.path_, path) &&
+        configuration_ == strings_ + e.configuration_)
+      return entry;
+  }
+}
+
+ScanCache::ScanCache(const char* configuration)
+    : impl_(new ScanCacheImpl(configuration)) {
+}
+
+ScanCache::~ScanCache() {
+  delete impl_;
+}
+
+bool ScanCache::Load(const char* file_name) {
+  ScanCacheImpl& impl = *impl_;
+  impl.unload();
+
+  const int fd = open(file_name, O_RDONLY);
+  if (fd < 0)
+    return ENOENT == errno;
+
+  struct stat status;
+  void* map = MAP_FAILED;
+  if (0 == fstat(fd, &status) && S_ISREG(status.st_mode) &&
+      status.st_size > 0) {
+    map = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (MAP_FAILED == map)
+    return false;
+
+  impl.map_ = map;
+  impl.map_size_ = status.st_size;
+  const char* p = static_cast<const char*>(map);
+  impl.header_ = reinterpret_cast<const CacheHeader*>(p);
+  if (impl.map_size_ >= sizeof *impl.header_) {
+    const CacheHeader& h = *impl.header_;
+    impl.entries_ = reinterpret_cast<const CacheEntry*>(p + sizeof h);
+    impl.slots_ = reinterpret_cast<const uint32_t*>(impl.entries_ +
+                                                    h.num_entries_);
+    impl.names_ = impl.slots_ + h.num_slots_;
+    impl.strings_ = reinterpret_cast<const char*>(impl.names_ +
+                                                  h.num_names_);
+  }
+  if (!impl.check()) {
+    impl.unload();
+    return false;
+  }
+  impl.num_loaded_ = impl.header_->num_entries_;
+  return true;
+}
+
+int ScanCache::Find(const char* path, const struct stat& status) const {
+  const int added = impl_->added_paths_.GetIndexByName(path);
+  if (added >= 0) {
+    return hasIdentity(impl_->added_[added].entry_, status)
+         ? impl_->num_loaded_ + added
+         : NO_ENTRY;
+  }
+  const int entry = impl_->findLoaded(path);
+  return entry >= 0 && hasIdentity(impl_->entries_[entry], status)
+       ? entry
+       : NO_ENTRY;
+}
+
+int ScanCache::Add(const char* path,
+                   const struct stat& status,
+                   const NameArray& names,
+                   int num_skipped) {
+  ScanCacheImpl& impl = *impl_;
+  const int length = impl.added_paths_.Length();
+  const int added = impl.added_paths_.Entry(path);
+  if (added >= impl.added_size_) {
+    impl.added_ = resize(impl.added_, length,
+                         impl.added_size_ * GROW_FACTOR);
+    impl.added_size_ *= GROW_FACTOR;
+  }
+
+  AddedEntry& a = impl.added_[added];
+  setIdentity(&a.entry_, status);
+  a.entry_.first_name_ = impl.added_names_.Length();
+  a.entry_.num_names_ = names.Length();
+  a.entry_.num_skipped_ = num_skipped;
+  for (int i = 0; i < names.Length(); ++i)
+    impl.added_names_.Append(names[i]);
+  a.save_ = status.st_mtime < impl.racy_time_;
+  impl.dirty_ = impl.dirty_ || a.save_;
+  return impl.num_loaded_ + added;
+}
+
+int ScanCache::NumNames(int entry) const {
+  return entry < impl_->num_loaded_
+       ? impl_->entries_[entry].num_names_
+       : impl_->added_[entry - impl_->num_loaded_].entry_.num_names_;
+}
+
+const char* ScanCache::Name(int entry, int index) const {
+  if (entry < impl_->num_loaded_) {
+    const CacheEntry& e = impl_->entries_[entry];
+    return impl_->strings_ + impl_->names_[e.first_name_ + index];
+  }
+  const CacheEntry& e = impl_->added_[entry - impl_->num_loaded_].entry_;
+  return impl_->added_names_[e.first_name_ + index];
+}
+
+int ScanCache::NumSkipped(int entry) const {
+  return entry < impl_->num_loaded_
+       ? impl_->entries_[entry].num_skipped_
+       : impl_->added_[entry - impl_->num_loaded_].entry_.num_skipped_;
+}
+
+bool ScanCache::Save(const char* file_name) const {
+  const ScanCacheImpl& impl = *impl_;
+  if (!impl.dirty_)
+    return true;
+
+  // Gather the loaded entries that were not replaced, then those added.
+
+  const int num_added = impl.added_paths_.Length();
+  CacheEntry* entries = new CacheEntry[impl.num_loaded_ + num_added];
+  int num_entries = 0;
+  int names_size = START_SIZE;
+  uint32_t* names = new uint32_t[names_size];
+  int num_names = 0;
+  StringPool pool;
+
+  for (int i = 0; i < impl.num_loaded_ + num_added; ++i) {
+    const CacheEntry* from;
+    const char* path;
+    const char* configuration;
+    if (i < impl.num_loaded_) {
+      from = &impl.entries_[i];
+      path = impl.strings_ + from->path_;
+      configuration = impl.strings_ + from->configuration_;
+      if (impl.configuration_ == configuration &&
+          impl.added_paths_.GetIndexByName(path) >= 0)
+        continue;                       // replaced
+      struct stat status;
+      if (0 != stat(path, &status) || !hasIdentity(*from, status))
+        continue;                       // removed or changed since
+    } else {
+      const AddedEntry& a = impl.added_[i - impl.num_loaded_];
+      if (!a.save_)
+        continue;
+      from = &a.entry_;
+      path = impl.added_paths_[i - impl.num_loaded_];
+      configuration = impl.configuration_.c_str();
+    }
+
+    CacheEntry& e = entries[num_entries++];
+    e = *from;
+    e.path_ = pool.Offset(path);
+    e.configuration_ = pool.Offset(configuration);
+    e.first_name_ = num_names;
+    e.hash_ = hashOf(hashOf(2166136261u, configuration), path);
+    for (uint32_t k = 0; k < from->num_names_; ++k) {
+      if (num_names >= names_size) {
+        names = resize(names, num_names, names_size * GROW_FACTOR);
+        names_size *= GROW_FACTOR;
+      }
+      names[num_names++] = pool.Offset(i < impl.num_loaded_
+          ? impl.strings_ + impl.names_[from->first_name_ + k]
+          : impl.added_names_[from->first_name_ + k]);
+    }
+  }
+
+  // Build the hash table of the entries.
+
+  uint32_t num_slots = MIN_SLOTS;
+  while (num_slots < GROW_FACTOR * static_cast<uint32_t>(num_entries + 1))
+    num_slots *= GROW_FACTOR;
+  uint32_t* slots = new uint32_t[num_slots];
+  memset(slots, 0, num_slots * sizeof *slots);
+  for (int i = 0; i < num_entries; ++i) {
+    uint32_t s = entries[i].hash_ & (num_slots - 1);
+    while (slots[s])
+      s = (s + 1) & (num_slots - 1);
+    slots[s] = i + 1;
+  }
+
+  CacheHeader header;
+  memcpy(header.magic_, kMagic, MAGIC_LENGTH);
+  header.version_ = VERSION;
+  header.byte_order_ = BYTE_ORDER_MARK;
+  header.num_entries_ = num_entries;
+  header.num_slots_ = num_slots;
+  header.num_names_ = num_names;
+  header.strings_length_ = pool.Pool().size();
+
+  // Write a temporary file next to the cache file and rename it.
+
+  char pid[32];
+  snprintf(pid, sizeof pid, ".%ld.tmp", static_cast<long>(getpid()));
+  const std::string temp = std::string(file_name) + pid;
+  const int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  bool ok = fd >= 0 &&
+            writeAll(fd, &header, sizeof header) &&
+            writeAll(fd, entries, num_entries * sizeof *entries) &&
+            writeAll(fd, slots, num_slots * sizeof *slots) &&
+            writeAll(fd, names, num_names * sizeof *names) &&
+            writeAll(fd, pool.Pool().data(), pool.Pool().size());
+  if (fd >= 0)
+    ok = 0 == close(fd) && ok;
+  ok = ok && 0 == rename(temp.c_str(), file_name);
+  if (!ok && fd >= 0)
+    unlink(temp.c_str());
+
+  delete[] slots;
+  delete[] names;
+  delete[] entries;
+  return ok;
+}
+
+                // -*-*-*- ScanCacheIterator -*-*-*-
+
+struct ScanCacheIteratorImpl {
+  FileDepIterator* file_p;      // used if there is no entry, or 0
+  const ScanCache* cache_p;
+  int entry_;                   // entry of the file, or NO_ENTRY
+  int index_;                   // index of current name of entry_
+  bool valid_;                  // whether the file could be opened
+};
+
+ScanCacheIterator::ScanCacheIterator(ScanCache* cache,
+                                     const char* file_name,
+                                     const MacroTable* macros)
+    : impl_(new ScanCacheIteratorImpl) {
+  ScanCacheIteratorImpl& impl = *impl_;
+  impl.file_p = 0;
+  impl.cache_p = cache;
+  impl.entry_ = NO_ENTRY;
+  impl.index_ = 0;
+  impl.valid_ = true;
+
+  struct stat status;
+  const bool known = cache && 0 == stat(file_name, &status);
+  if (known) {
+    impl.entry_ = cache->Find(file_name, status);
+    if (impl.entry_ >= 0)
+      return;
+  }
+
+  impl.file_p = new FileDepIterator(file_name, macros);
+  if (!known || !impl.file_p->IsValidFile())
+    return;
+
+  NameArray names;
+  for (; *impl.file_p; ++*impl.file_p)
+    names.Append((*impl.file_p)());
+  impl.entry_ = cache->Add(file_name, status, names,
+                           impl.file_p->NumSkipped());
+  delete impl.file_p;
+  impl.file_p = 0;
+}
+
+ScanCacheIterator::~ScanCacheIterator() {
+  delete impl_->file_p;
+  delete impl_;
+}
+
+bool ScanCacheIterator::IsValidFile() const {
+  return impl_->file_p ? impl_->file_p->IsValidFile() : impl_->valid_;
+}
+
+void ScanCacheIterator::operator++() {
+  if (impl_->file_p)
+    ++*impl_->file_p;
+  else
+    ++impl_->index_;
+}
+
+ScanCacheIterator::operator const void *() const {
+  if (impl_->file_p)
+    return *impl_->file_p;
+  return impl_->index_ < impl_->cache_p->NumNames(impl_->entry_) ? this : 0;
+}
+
+const char* ScanCacheIterator::operator()() const {
+  if (impl_->file_p)
+    return (*impl_->file_p)();
+  return *this ? impl_->cache_p->Name(impl_->entry_, impl_->index_) : 0;
+}
+
+int ScanCacheIterator::NumSkipped() const {
+  return impl_->file_p ? impl_->file_p->NumSkipped()
+                       : impl_->cache_p->NumSkipped(impl_->entry_);
+}
+
+}  // namespace idep
@@ -0,0 +1,118 @@
+#ifndef IDEP_SCAN_CACHE_H_
+#define IDEP_SCAN_CACHE_H_
+
+// This component defines 2 fully insulated classes:
+//           ScanCache: include directives found in files, kept on disk
+//   ScanCacheIterator: a FileDepIterator that goes through a ScanCache
+
+#include <sys/stat.h>
+
+#include "basictypes.h"
+
+namespace idep {
+
+class FileDepIterator;
+class MacroTable;
+class NameArray;
+
+struct ScanCacheImpl;
+
+// The include names found in files by FileDepIterator, each recorded
+// with the identity of the file when it was scanned (device, inode,
+// size and modification time), so that a file need not be scanned again
+// until its identity changes.  The cache is kept in a binary file that
+// is mapped into memory as it is, so loading it costs next to nothing.
+// Since the names found depend on how a file is scanned (e.g., which
+// macros are defined), each entry is also keyed by a configuration
+// string; a cache shows only the entries of its own configuration, but
+// keeps the others when it is saved.
+class ScanCache {
+ public:
+  // Create an empty cache for files scanned in the mode described by the
+  // specified configuration, which is any text that differs between
+  // modes that can find different names ("" for the default mode).
+  explicit ScanCache(const char* configuration);
+  ~ScanCache();
+
+  // Load the contents of the cache file having the specified name.
+  // Return true on success or if there is no such file, and false if the
+  // file is not a valid cache file (in which case it is ignored, and
+  // will be replaced by Save()).
+  bool Load(const char* file_name);
+
+  // Return the entry of the file at the specified path if it is cached
+  // with the identity given by the specified status, and -1 otherwise.
+  int Find(const char* path, const struct stat& status) const;
+
+  // Record the specified names, found in the specified file with the
+  // specified identity, along with the number of include directives
+  // skipped there, and return the new entry.  This entry replaces any
+  // other entry of the same file.  A file modified within the last
+  // moment could change again without its identity changing, so such an
+  // entry is only kept for this run, and not saved.
+  int Add(const char* path,
+          const struct stat& status,
+          const NameArray& names,
+          int num_skipped);
+
+  // Return the number of names of the specified entry.
+  int NumNames(int entry) const;
+
+  // Return the name of the specified entry having the specified index.
+  const char* Name(int entry, int index) const;
+
+  // Return the number of include directives skipped in the file of the
+  // specified entry.
+  int NumSkipped(int entry) const;
+
+  // Write this cache to the file having the specified name, if any entry
+  // has been added since it was loaded.  Entries of files that no longer
+  // exist, or that have changed since they were cached, are dropped.
+  // The file is replaced at once, so that a concurrent Load() sees
+  // either the old or the new cache.  Return false on error.
+  bool Save(const char* file_name) const;
+
+ private:
+  ScanCacheImpl* impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanCache);
+};
+
+struct ScanCacheIteratorImpl;
+
+// Iterate over the include names of a file, exactly as FileDepIterator
+// does, but take them from the specified ScanCache if it has them, and
+// add them to it otherwise.  With no cache, this is a FileDepIterator.
+class ScanCacheIterator {
+ public:
+  ScanCacheIterator(ScanCache* cache,
+                    const char* file_name,
+                    const MacroTable* macros = 0);
+  ~ScanCacheIterator();
+
+  // Return true if the specified file could be opened, whether or not it
+  // contains any include directives.
+  bool IsValidFile() const;
+
+  // Advance to the next include name of the file.
+  void operator++();
+
+  // Return non-zero if the current name is valid, and 0 otherwise.
+  operator const void *() const;
+
+  // Return the current name, or 0 if the iteration state is not valid.
+  const char* operator()() const;
+
+  // Return the number of include directives skipped in the file; see
+  // FileDepIterator::NumSkipped().
+  int NumSkipped() const;
+
+ private:
+  ScanCacheIteratorImpl* impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanCacheIterator);
+};
+
+}  // namespace idep
+
+#endif  // IDEP_SCAN_CACHE_H_
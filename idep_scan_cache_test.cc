@@ -0,0 +1,226 @@
+// Check that a ScanCache hands back the names it recorded for a file
+// while the identity of the file is unchanged, even across Save() and
+// Load(), and rescans the file once its size or modification time
+// changes; that entries of files modified within the last two seconds
+// are not saved; that entries are kept per configuration; and that a
+// corrupt cache file is ignored and then replaced.  A file is rewritten
+// with the same size and modification time to tell a cached scan from
+// a fresh one.  Exit with the number of mismatches found.
+
+#include "idep_scan_cache.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace {
+
+using idep::ScanCache;
+using idep::ScanCacheIterator;
+
+std::string g_dir;              // directory holding the test files
+
+std::string Path(const char* name) {
+  return g_dir + "/" + name;
+}
+
+// Replace the contents of the specified file with the specified text
+// and, unless |mtime| is 0, set its modification time to |mtime|.
+void Write(const std::string& path, const char* text, time_t mtime) {
+  FILE* out = fopen(path.c_str(), "w");
+  if (out) {
+    fputs(text, out);
+    fclose(out);
+  }
+  if (mtime) {
+    struct timeval times[2];
+    times[0].tv_sec = times[1].tv_sec = mtime;
+    times[0].tv_usec = times[1].tv_usec = 0;
+    utimes(path.c_str(), times);
+  }
+}
+
+// Return the names found in the specified file through the specified
+// cache, separated by spaces.
+std::string Scan(ScanCache* cache, const std::string& path) {
+  std::string names;
+  for (ScanCacheIterator it(cache, path.c_str()); it; ++it) {
+    if (!names.empty())
+      names += ' ';
+    names += it();
+  }
+  return names;
+}
+
+// Return 0 if the specified names are those expected, and 1 (after
+// reporting the difference) otherwise.
+int Expect(const char* what, const std::string& names, const char* expected) {
+  if (names == expected)
+    return 0;
+  printf("FAIL: %s: found \"%s\" rather than \"%s\"\n", what, names.c_str(),
+         expected);
+  return 1;
+}
+
+// Return 0 if the specified condition holds, and 1 (after reporting it)
+// otherwise.
+int Expect(const char* what, bool condition) {
+  if (condition)
+    return 0;
+  printf("FAIL: %s\n", what);
+  return 1;
+}
+
+}  // namespace
+
+int main() {
+  char dir[] = "/tmp/idep_scan_cache_test.XXXXXX";
+  if (!mkdtemp(dir)) {
+    printf("FAIL: cannot create a temporary directory\n");
+    return 1;
+  }
+  g_dir = dir;
+  const std::string cacheFile = Path("cache");
+  const std::string a = Path("a.cc");
+  const std::string b = Path("b.cc");
+  const std::string racy = Path("racy.cc");
+  const std::string other = Path("other.cc");
+  const time_t old = time(0) - 100;     // well before the racy window
+
+  int failures = 0;
+
+  // A missing cache file loads as an empty cache.
+  {
+    ScanCache cache("");
+    failures += Expect("a missing cache file loads",
+                       cache.Load(cacheFile.c_str()));
+    Write(a, "#include <a1.h>\n#include <a2.h>\n", old);
+    Write(b, "#include <b1.h>\n", old);
+    failures += Expect("first scan", Scan(&cache, a), "a1.h a2.h");
+    Write(a, "#include <x1.h>\n#include <x2.h>\n", old);
+    failures += Expect("hit in the same run", Scan(&cache, a), "a1.h a2.h");
+    failures += Expect("first scan of another file", Scan(&cache, b), "b1.h");
+    failures += Expect("save", cache.Save(cacheFile.c_str()));
+  }
+
+  // Hits after Save() and Load(); a change of size or modification time
+  // makes the file be scanned again.
+  {
+    ScanCache cache("");
+    failures += Expect("load", cache.Load(cacheFile.c_str()));
+    failures += Expect("hit after loading", Scan(&cache, a), "a1.h a2.h");
+    Write(b, "#include <b22.h>\n", old);
+    failures += Expect("miss after a change of size", Scan(&cache, b),
+                       "b22.h");
+  }
+  {
+    ScanCache cache("");
+    cache.Load(cacheFile.c_str());
+    Write(a, "#include <y1.h>\n#include <y2.h>\n", old + 1);
+    failures += Expect("miss after a change of time", Scan(&cache, a),
+                       "y1.h y2.h");
+  }
+
+  // A file modified within the racy window is cached for this run only,
+  // and Save() drops the loaded entries of files changed since.
+  {
+    ScanCache cache("");
+    cache.Load(cacheFile.c_str());
+    Write(racy, "#include <r1.h>\n", time(0));
+    failures += Expect("first scan of a racy file", Scan(&cache, racy),
+                       "r1.h");
+    Write(other, "#include <o1.h>\n", old);
+    failures += Expect("first scan after loading", Scan(&cache, other),
+                       "o1.h");
+    failures += Expect("save again", cache.Save(cacheFile.c_str()));
+  }
+  {
+    struct stat status;
+    stat(racy.c_str(), &status);
+    Write(racy, "#include <r2.h>\n", status.st_mtime);  // same identity
+    Write(other, "#include <o2.h>\n", old);
+    ScanCache cache("");
+    cache.Load(cacheFile.c_str());
+    failures += Expect("a racy file is not saved", Scan(&cache, racy),
+                       "r2.h");
+    failures += Expect("hit on a file added after loading",
+                       Scan(&cache, other), "o1.h");
+
+    // Give the file its cached identity back: the entry must be gone.
+    Write(a, "#include <z1.h>\n#include <z2.h>\n", old);
+    failures += Expect("a changed file is dropped on saving",
+                       Scan(&cache, a), "z1.h z2.h");
+  }
+
+  // Entries are keyed by configuration, and entries of other
+  // configurations survive a Save().
+  {
+    ScanCache cache("-DX");
+    cache.Load(cacheFile.c_str());
+    failures += Expect("miss in another configuration", Scan(&cache, other),
+                       "o2.h");
+    failures += Expect("save another configuration",
+                       cache.Save(cacheFile.c_str()));
+  }
+  Write(other, "#include <o3.h>\n", old);
+  {
+    ScanCache cache("");
+    cache.Load(cacheFile.c_str());
+    failures += Expect("hit in the first configuration",
+                       Scan(&cache, other), "o1.h");
+  }
+  {
+    ScanCache cache("-DX");
+    cache.Load(cacheFile.c_str());
+    failures += Expect("hit in the second configuration",
+                       Scan(&cache, other), "o2.h");
+  }
+
+  // A corrupt or truncated cache file is ignored, and replaced on saving.
+  {
+    struct stat status;
+    stat(cacheFile.c_str(), &status);
+    if (0 != truncate(cacheFile.c_str(), status.st_size - 1))
+      failures += Expect("truncate the cache file", false);
+    ScanCache cache("");
+    failures += Expect("a truncated cache file does not load",
+                       !cache.Load(cacheFile.c_str()));
+    failures += Expect("miss after a truncated cache file",
+                       Scan(&cache, other), "o3.h");
+  }
+  {
+    Write(cacheFile, "IDEPSCAN but not really a cache file", 0);
+    ScanCache cache("");
+    failures += Expect("a corrupt cache file does not load",
+                       !cache.Load(cacheFile.c_str()));
+    failures += Expect("miss after a corrupt cache file",
+                       Scan(&cache, other), "o3.h");
+    failures += Expect("replace a corrupt cache file",
+                       cache.Save(cacheFile.c_str()));
+  }
+  {
+    Write(other, "#include <o4.h>\n", old);
+    ScanCache cache("");
+    failures += Expect("a replaced cache file loads",
+                       cache.Load(cacheFile.c_str()));
+    failures += Expect("hit after replacing a corrupt cache file",
+                       Scan(&cache, other), "o3.h");
+  }
+
+  const char* const files[] = { "a.cc", "b.cc", "racy.cc", "other.cc",
+                                "cache" };
+  for (size_t i = 0; i < sizeof files / sizeof *files; ++i)
+    unlink(Path(files[i]).c_str());
+  rmdir(dir);
+
+  if (0 == failures)
+    printf("The scan cache behaves as expected.\n");
+  return failures;
+}
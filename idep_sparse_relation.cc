@@ -0,0 +1,163 @@
+#include "idep_sparse_relation.h"
+
+#include <assert.h>
+#include <memory.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "idep_strong_components.h"
+
+// IMPLEMENTATION NOTE: MEMORY LAYOUT
+// Edges are first collected, unsorted and possibly repeated, in a pair of
+// parallel arrays.  freeze() merges them into compressed sparse rows:
+//
+//   d_offsets_p:  [ 0 | 2 | 2 | 5 | ... | E ]      (Length() + 1 entries)
+//                   |       |   |
+//                   v       v   v
+//   d_columns_p:  [ 3 | 7 | 0 | 4 | 9 | ... ]      (E entries)
+//                 \_row 0_/   \_ row 2 _/
+//
+// so memory is proportional to Length() + E rather than Length()^2.
+
+enum { START_SIZE = 1, GROW_FACTOR = 2 };
+
+namespace {
+
+struct RowSuccessors {
+    // Enumerate the columns of a compressed row for idep::StrongComponents.
+    const int *offsets;
+    const int *columns;
+
+    int operator()(int row, int *cursor) const {
+        const int i = offsets[row] + *cursor;
+        if (i >= offsets[row + 1]) {
+            return -1;
+        }
+        ++*cursor;
+        return columns[i];
+    }
+};
+
+}  // namespace
+
+namespace idep {
+
+SparseRelation::SparseRelation(int initial_entries, int max_edges_hint)
+    : d_numPending(0),
+      d_pendingSize(max_edges_hint > 0 ? max_edges_hint : START_SIZE),
+      d_numFrozenRows(0),
+      d_length(initial_entries > 0 ? initial_entries : 0) {
+    d_pendingRows_p = new int[d_pendingSize];
+    d_pendingCols_p = new int[d_pendingSize];
+    d_offsets_p = new int[1];
+    d_offsets_p[0] = 0;
+    d_columns_p = new int[1];
+}
+
+SparseRelation::~SparseRelation() {
+    delete [] d_pendingRows_p;
+    delete [] d_pendingCols_p;
+    delete [] d_offsets_p;
+    delete [] d_columns_p;
+}
+
+void SparseRelation::growPending() {
+    int newSize = d_pendingSize * GROW_FACTOR;
+    int *rows = new int[newSize];
+    int *cols = new int[newSize];
+    memcpy(rows, d_pendingRows_p, d_numPending * sizeof *rows);
+    memcpy(cols, d_pendingCols_p, d_numPending * sizeof *cols);
+    delete [] d_pendingRows_p;
+    delete [] d_pendingCols_p;
+    d_pendingRows_p = rows;
+    d_pendingCols_p = cols;
+    d_pendingSize = newSize;
+}
+
+void SparseRelation::freeze() {
+    if (isFrozen()) {
+        return;
+    }
+
+    // Bucket the previously frozen and the newly collected edges by row
+    // (a counting sort), then sort and remove duplicates within each row.
+
+    const int n = d_length;
+    const int total = numEdges() + d_numPending;
+
+    int *offsets = new int[n + 1];
+    memset(offsets, 0, (n + 1) * sizeof *offsets);
+    for (int r = 0; r < d_numFrozenRows; ++r) {
+        offsets[r + 1] += numSuccessors(r);
+    }
+    for (int i = 0; i < d_numPending; ++i) {
+        assert(d_pendingRows_p[i] >= 0 && d_pendingRows_p[i] < n);
+        assert(d_pendingCols_p[i] >= 0 && d_pendingCols_p[i] < n);
+        ++offsets[d_pendingRows_p[i] + 1];
+    }
+    for (int r = 0; r < n; ++r) {
+        offsets[r + 1] += offsets[r];
+    }
+
+    int *cursor = new int[n > 0 ? n : 1];
+    memcpy(cursor, offsets, n * sizeof *cursor);
+    int *columns = new int[total > 0 ? total : 1];
+    for (int r = 0; r < d_numFrozenRows; ++r) {
+        const int *p = successors(r);
+        for (int i = numSuccessors(r); i > 0; --i) {
+            columns[cursor[r]++] = *p++;
+        }
+    }
+    for (int i = 0; i < d_numPending; ++i) {
+        columns[cursor[d_pendingRows_p[i]]++] = d_pendingCols_p[i];
+    }
+    delete [] cursor;
+
+    int length = 0;
+    for (int r = 0; r < n; ++r) {
+        const int begin = offsets[r];
+        const int end = offsets[r + 1];
+        std::sort(columns + begin, columns + end);
+        offsets[r] = length;
+        for (int i = begin; i < end; ++i) {
+            if (i == begin || columns[i] != columns[i - 1]) {
+                columns[length++] = columns[i];
+            }
+        }
+    }
+    offsets[n] = length;
+
+    delete [] d_offsets_p;
+    delete [] d_columns_p;
+    d_offsets_p = offsets;
+    d_columns_p = columns;
+    d_numFrozenRows = n;
+    d_numPending = 0;
+}
+
+int SparseRelation::get(int row, int col) const {
+    assert(isFrozen());
+    const int *begin = successors(row);
+    return std::binary_search(begin, begin + numSuccessors(row), col);
+}
+
+int SparseRelation::strongComponents(int *components) const {
+    assert(isFrozen());
+    const RowSuccessors next = { d_offsets_p, d_columns_p };
+    return StrongComponents(d_length, next, components);
+}
+
+std::ostream& operator<<(std::ostream& o, const SparseRelation& rel) {
+    for (int r = 0; r < rel.Length(); ++r) {
+        o << r << ':';
+        const int *p = rel.successors(r);
+        for (int i = rel.numSuccessors(r); i > 0; --i) {
+            o << ' ' << *p++;
+        }
+        o << std::endl;
+    }
+    return o;
+}
+
+}  // namespace idep
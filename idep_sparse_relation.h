@@ -0,0 +1,121 @@
+#ifndef IDEP_SPARSE_RELATION_H_
+#define IDEP_SPARSE_RELATION_H_
+
+#include <ostream>
+
+#include "basictypes.h"
+
+namespace idep {
+
+// This component defines 1 class:
+// Sparse binary relation stored as compressed rows (adjacency lists).
+class SparseRelation {
+ public:
+  // Create a sparse relation that can be extended as needed.  By default,
+  // the initial number of entries in the relation is 0.  If the number of
+  // 1's (edges) to be set is known, it may optionally be specified as the
+  // second argument (as a "hint").
+  SparseRelation(int initial_entries = 0, int max_edges_hint = 0);
+  ~SparseRelation();
+
+  int appendEntry();
+  // Append an entry to this relation and return its integer index.
+  // The logical size is increased by 1 with no edges to or from the new
+  // entry.
+
+  void set(int row, int col);
+  // Set the specified row/col of this relation to 1.  Edges are only
+  // collected here, so setting the same edge more than once is cheap;
+  // the accessors below do not see the edge until freeze() is called.
+
+  void freeze();
+  // Sort and merge all edges set so far into compressed rows, discarding
+  // duplicates.  This takes O(Length() + E) time, where E is the number of
+  // edges set since the last call.  The relation may be extended again
+  // afterwards, but must then be frozen again before it is accessed.
+
+  // ACCESSORS
+  int get(int row, int col) const;
+  // Get the boolean value at the specified row/col of this relation.
+
+  int numSuccessors(int row) const;
+  // Return the number of 1's in the specified row.
+
+  const int *successors(int row) const;
+  // Return the columns of the 1's in the specified row, in increasing
+  // order.  The array holds numSuccessors(row) values.
+
+  int numEdges() const;
+  // Return the total number of 1's in this relation.
+
+  int strongComponents(int *components) const;
+  // Partition the entries of this relation into strongly connected
+  // components and load the component index of each entry into the
+  // specified array, which must have room for Length() values.
+  // Components are numbered in reverse topological order, exactly as by
+  // BinaryRelation::strongComponents.  Return the number of components.
+  // This function runs in O(Length() + numEdges()) time.
+
+  int Length() const;
+  // Return the number of rows and columns in this relation.
+
+  int isFrozen() const;
+  // Return 1 if every edge has been merged by freeze(); else 0.
+
+ private:
+  // Double the capacity of the collected edge arrays.
+  void growPending();
+
+  int *d_pendingRows_p;   // rows of edges set since the last freeze
+  int *d_pendingCols_p;   // columns of edges set since the last freeze
+  int d_numPending;       // number of edges set since the last freeze
+  int d_pendingSize;      // physical size of the collected edge arrays
+
+  int *d_offsets_p;       // start of each frozen row in d_columns_p
+  int *d_columns_p;       // frozen columns, row by row
+  int d_numFrozenRows;    // number of rows in d_offsets_p
+  int d_length;           // logical size of relation
+
+  DISALLOW_COPY_AND_ASSIGN(SparseRelation);
+};
+
+// Output this relation as one line per row listing the columns of its
+// 1's to the specified output stream (out).
+std::ostream& operator<<(std::ostream& out, const SparseRelation& rel);
+
+inline int SparseRelation::appendEntry() {
+    return d_length++;
+}
+
+inline void SparseRelation::set(int row, int col) {
+    if (d_numPending >= d_pendingSize) {
+        growPending();
+    }
+    d_pendingRows_p[d_numPending] = row;
+    d_pendingCols_p[d_numPending] = col;
+    ++d_numPending;
+}
+
+inline int SparseRelation::numSuccessors(int row) const {
+    return d_offsets_p[row + 1] - d_offsets_p[row];
+}
+
+inline const int *SparseRelation::successors(int row) const {
+    return d_columns_p + d_offsets_p[row];
+}
+
+inline int SparseRelation::numEdges() const {
+    return d_offsets_p[d_numFrozenRows];
+}
+
+inline int SparseRelation::Length() const {
+    return d_length;
+}
+
+inline int SparseRelation::isFrozen() const {
+    return 0 == d_numPending && d_numFrozenRows == d_length;
+}
+
+}  // namespace idep
+
+#endif  // IDEP_SPARSE_RELATION_H_
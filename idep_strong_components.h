@@ -0,0 +1,112 @@
+#ifndef IDEP_STRONG_COMPONENTS_H_
+#define IDEP_STRONG_COMPONENTS_H_
+
+namespace idep {
+
+// This leaf component defines 1 function template:
+// Tarjan's strong components over any relation whose successors can be
+// enumerated one at a time.
+
+// Partition the entries [0 .. length - 1] of a relation into strongly
+// connected components (maximal sets of mutually reachable entries) and
+// load the component index of each entry into the specified array, which
+// must have room for |length| values.  Components are numbered in reverse
+// topological order: an entry depends only on entries in the same or a
+// lower-numbered component.  Return the number of components.
+//
+// The successors of an entry v are enumerated by calling next(v, &cursor),
+// where cursor is 0 on the first call for v and is otherwise left as the
+// previous call for v left it; next must return the following successor
+// of v (advancing cursor past it), or -1 if there are no more.  Each
+// successor is requested once, so this runs in O(length + E) time plus
+// the cost of enumerating the E successors.
+template <class NextSuccessor>
+int StrongComponents(int length, const NextSuccessor& next, int *components);
+
+// ============================================================================
+//                      INLINE FUNCTION DEFINITIONS
+// ============================================================================
+
+template <class NextSuccessor>
+int StrongComponents(int length, const NextSuccessor& next, int *components) {
+    // An explicit stack takes the place of recursion so that long
+    // dependency chains cannot overflow the program stack.  A component is
+    // emitted only after every component reachable from it, which yields
+    // the reverse topological numbering.
+    //
+    // See Tarjan, R. E. [1972]. "Depth-first search and linear graph
+    // algorithms," SIAM Journal on Computing, 1:2, pp. 146-160.
+
+    enum { UNVISITED = -1, UNASSIGNED = -1 };
+    const int s = length;
+
+    int *order = new int[s];    // discovery order of each entry
+    int *low = new int[s];      // lowest order reachable via the DFS tree
+    int *cursor = new int[s];   // enumeration state of each entry
+    int *pending = new int[s];  // entries not yet assigned a component
+    int *path = new int[s];     // current path of the depth-first search
+    int numPending = 0;
+    int numVisited = 0;
+    int numComponents = 0;
+
+    for (int i = 0; i < s; ++i) {
+        order[i] = UNVISITED;
+        components[i] = UNASSIGNED;
+    }
+
+    for (int root = 0; root < s; ++root) {
+        if (UNVISITED != order[root]) {
+            continue;
+        }
+        int depth = 0;
+        int v = root;
+        for (;;) {
+            if (UNVISITED == order[v]) {                // enter v
+                order[v] = low[v] = numVisited++;
+                cursor[v] = 0;
+                pending[numPending++] = v;
+                path[depth++] = v;
+            }
+            v = path[depth - 1];
+            const int u = next(v, &cursor[v]);
+            if (u >= 0) {
+                if (UNVISITED == order[u]) {
+                    v = u;                              // descend into u
+                }
+                else if (UNASSIGNED == components[u] && order[u] < low[v]) {
+                    low[v] = order[u];                  // u is still pending
+                }
+                continue;
+            }
+
+            if (low[v] == order[v]) {                   // v is a root
+                int m;
+                do {
+                    m = pending[--numPending];
+                    components[m] = numComponents;
+                } while (m != v);
+                ++numComponents;
+            }
+            if (--depth == 0) {
+                break;
+            }
+            const int parent = path[depth - 1];
+            if (low[v] < low[parent]) {
+                low[parent] = low[v];
+            }
+            v = parent;
+        }
+    }
+
+    delete [] order;
+    delete [] low;
+    delete [] cursor;
+    delete [] pending;
+    delete [] path;
+
+    return numComponents;
+}
+
+}  // namespace idep
+
+#endif  // IDEP_STRONG_COMPONENTS_H_
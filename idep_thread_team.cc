@@ -0,0 +1,110 @@
+#include "idep_thread_team.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>     // sysconf()
+
+namespace idep {
+
+struct ThreadTeamWorker {
+  ThreadTeamImpl* team_;
+  int thread_;
+};
+
+struct ThreadTeamImpl {
+  explicit ThreadTeamImpl(int size);
+  ~ThreadTeamImpl();
+
+  int size_;
+  ThreadTeam::Job job_;
+  void* arg_;
+
+  // A reusable barrier: the last thread to arrive advances the
+  // generation and wakes the others.
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  int arrived_;
+  unsigned generation_;
+};
+
+ThreadTeamImpl::ThreadTeamImpl(int size)
+    : size_(size > 0 ? size : 1),
+      job_(0),
+      arg_(0),
+      arrived_(0),
+      generation_(0) {
+  pthread_mutex_init(&mutex_, 0);
+  pthread_cond_init(&cond_, 0);
+}
+
+ThreadTeamImpl::~ThreadTeamImpl() {
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+static void* RunWorker(void* arg) {
+  ThreadTeamWorker* worker = static_cast<ThreadTeamWorker*>(arg);
+  ThreadTeamImpl* team = worker->team_;
+  team->job_(team->arg_, worker->thread_, team->size_);
+  return 0;
+}
+
+ThreadTeam::ThreadTeam(int size)
+    : impl_(new ThreadTeamImpl(size)) {
+}
+
+ThreadTeam::~ThreadTeam() {
+  delete impl_;
+}
+
+void ThreadTeam::Run(Job job, void* arg) {
+  impl_->job_ = job;
+  impl_->arg_ = arg;
+
+  const int others = impl_->size_ - 1;
+  pthread_t* threads = new pthread_t[others > 0 ? others : 1];
+  ThreadTeamWorker* workers = new ThreadTeamWorker[others > 0 ? others : 1];
+  for (int i = 0; i < others; ++i) {
+    workers[i].team_ = impl_;
+    workers[i].thread_ = i + 1;
+    int rc = pthread_create(&threads[i], 0, RunWorker, &workers[i]);
+    assert(0 == rc);
+    (void) rc;
+  }
+
+  job(arg, 0, impl_->size_);
+
+  for (int i = 0; i < others; ++i)
+    pthread_join(threads[i], 0);
+
+  delete[] workers;
+  delete[] threads;
+}
+
+void ThreadTeam::Barrier() {
+  if (impl_->size_ <= 1)
+    return;
+
+  pthread_mutex_lock(&impl_->mutex_);
+  unsigned generation = impl_->generation_;
+  if (++impl_->arrived_ == impl_->size_) {
+    impl_->arrived_ = 0;
+    ++impl_->generation_;
+    pthread_cond_broadcast(&impl_->cond_);
+  } else {
+    while (generation == impl_->generation_)
+      pthread_cond_wait(&impl_->cond_, &impl_->mutex_);
+  }
+  pthread_mutex_unlock(&impl_->mutex_);
+}
+
+int ThreadTeam::Size() const {
+  return impl_->size_;
+}
+
+int ThreadTeam::HardwareThreads() {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? static_cast<int>(n) : 1;
+}
+
+}  // namespace idep
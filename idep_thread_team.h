@@ -0,0 +1,55 @@
+#ifndef IDEP_THREAD_TEAM_H_
+#define IDEP_THREAD_TEAM_H_
+
+#include "basictypes.h"
+
+namespace idep {
+
+struct ThreadTeamImpl;
+
+// This leaf component defines 1 fully insulated class:
+// A fixed-size team of threads that run the same job in parallel and
+// synchronize with one another at barriers.
+class ThreadTeam {
+ public:
+  // A job is invoked once on each thread of the team with the argument
+  // passed to Run(), the index of the thread in [0 .. size - 1] and the
+  // size of the team.
+  typedef void (*Job)(void* arg, int thread, int size);
+
+  // Create a team of the specified number of threads (at least 1).
+  explicit ThreadTeam(int size);
+  ~ThreadTeam();
+
+  // Invoke the specified job on every thread of this team and return
+  // once all of them have finished.  The calling thread acts as thread
+  // 0, so a team of size 1 runs the job synchronously.
+  void Run(Job job, void* arg);
+
+  // Block the calling thread until every thread of this team has called
+  // Barrier().  Memory written by any thread before the barrier is
+  // visible to every thread after it.  Must only be called from a job.
+  void Barrier();
+
+  // Return the number of threads in this team.
+  int Size() const;
+
+  // Return the number of processors available, or 1 if unknown.
+  static int HardwareThreads();
+
+ private:
+  ThreadTeamImpl* impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadTeam);
+};
+
+// Return the first index of the specified thread's share when |count|
+// items are divided as evenly as possible among |size| threads; the
+// share ends where that of the next thread begins.
+inline int ThreadShare(int count, int thread, int size) {
+  return static_cast<int>(static_cast<long long>(count) * thread / size);
+}
+
+}  // namespace idep
+
+#endif  // IDEP_THREAD_TEAM_H_
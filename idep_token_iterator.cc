@@ -1,15 +1,25 @@
 #include "idep_token_iterator.h"
 
 #include <assert.h>
-#include <ctype.h>      // isspace()
-#include <memory.h>     // memcpy()
+#include <memory.h>     // memcpy() memmove()
 
 #include <iostream>
 
-enum { START_SIZE = 1, GROW_FACTOR = 2 };
+#include "idep_char_scan.h"
 
-const char kNewLineChar = '\n';
-const char kNullChar= '\0';
+// IMPLEMENTATION NOTE: The stream is read through its stream buffer in
+// blocks of BLOCK_SIZE characters.  The current token is terminated in
+// place by overwriting the white-space character that follows it, so a
+// token is never copied unless it straddles the end of a block, in which
+// case the unscanned characters are moved to the front of the buffer
+// first (and the buffer doubled if the token fills it).  The newline
+// token is a separate constant, since the character it stands for may
+// have been overwritten to end the preceding word.  Blanks and words are
+// both found with CharScan, which examines many characters at a time.
+
+enum { BLOCK_SIZE = 1 << 16, GROW_FACTOR = 2 };
+
+static const char kNewLineToken[] = "\n";
 
 namespace idep {
 
@@ -17,46 +27,60 @@ struct TokenIteratorImpl {
   TokenIteratorImpl(std::istream& in);
   ~TokenIteratorImpl();
 
-  void Grow();
-  void AddChar(char ch);
-  void Advance();
+  // Move the characters from begin_ on to the front of the buffer,
+  // growing it if they fill it, and read as many more as fit.  Return
+  // the number of characters read.
+  int Fill();
 
   std::istream& in_;
-  char* buf_;
-  int size_;
-  int length_;
+  char* buf_;           // BLOCK_SIZE characters or more, plus a null char
+  int size_;            // physical size of buf_, less the extra character
+  int begin_;           // first character not yet tokenized
+  int end_;             // end of the characters read so far
+  const char* token_;   // current token
+  int length_;          // length of current token, or -1 if invalid
   int newline_flag_;
 };
 
 TokenIteratorImpl::TokenIteratorImpl(std::istream& in)
     : in_(in),
-      buf_(new char[START_SIZE]),
-      size_(START_SIZE),
+      buf_(new char[BLOCK_SIZE + 1]),
+      size_(BLOCK_SIZE),
+      begin_(0),
+      end_(0),
+      token_(0),
       length_(0),
       newline_flag_(0) {
   assert(buf_);
 }
 
 TokenIteratorImpl::~TokenIteratorImpl() {
-  delete buf_;
-}
-
-void TokenIteratorImpl::Grow() {
-  int new_size = size_ * GROW_FACTOR;
-  char* tmp = buf_;
-  buf_ = new char[new_size];
-  assert(buf_);
-  memcpy(buf_, tmp, size_);
-  size_ = new_size;
-  delete[] tmp;
+  delete[] buf_;
 }
 
-void TokenIteratorImpl::AddChar(char ch) {
-  if (length_ >= size_)
-    Grow();
-
-  assert(length_ < size_);
-  buf_[length_++] = ch;
+int TokenIteratorImpl::Fill() {
+  const int length = end_ - begin_;
+  if (length >= size_) {
+    const int new_size = size_ * GROW_FACTOR;
+    char* tmp = buf_;
+    buf_ = new char[new_size + 1];
+    assert(buf_);
+    memcpy(buf_, tmp + begin_, length);
+    size_ = new_size;
+    delete[] tmp;
+  } else if (begin_ > 0) {
+    memmove(buf_, buf_ + begin_, length);
+  }
+  begin_ = 0;
+  end_ = length;
+
+  if (!in_)
+    return 0;
+  const int n = in_.rdbuf()->sgetn(buf_ + end_, size_ - end_);
+  if (0 == n)
+    in_.setstate(std::ios::eofbit);
+  end_ += n;
+  return n;
 }
 
 TokenIterator::TokenIterator(std::istream& in)
@@ -71,39 +95,53 @@ TokenIterator::~TokenIterator() {
 void TokenIterator::operator++() {
   assert(*this);
 
-  impl_->length_ = 0;
-
-  if (impl_->newline_flag_) {                   // left over newline
-    impl_->newline_flag_ = 0;
-    impl_->AddChar(kNewLineChar);
-  } else {
-    char c;
-    while (impl_->in_ && !impl_->in_.get(c).eof()) {
-      if (impl_->length_ > 0) {            // "word" in progress
-        if (isspace(c)) {
-          if (kNewLineChar == c) {
-            impl_->newline_flag_ = 1; // note newline for later
-          }
-          break;                         // end of "word" in any case
-        }
-        impl_->AddChar(c);                // start of "word"
-      } else {                                 // nothing found yet
-        if (isspace(c)) {
-          if (kNewLineChar== c) {
-            impl_->AddChar(kNewLineChar);
-            break;                     // found a newline
-          }
-          continue;                      // found an ordinary space
-        }
-        impl_->AddChar(c);                // add character to "word"
-      }
+  TokenIteratorImpl& impl = *impl_;
+
+  if (impl.newline_flag_) {                     // left over newline
+    impl.newline_flag_ = 0;
+    impl.token_ = kNewLineToken;
+    impl.length_ = 1;
+    return;
+  }
+
+  for (;;) {                                    // skip ordinary spaces
+    impl.begin_ = CharScan::SkipBlanks(impl.buf_ + impl.begin_,
+                                       impl.buf_ + impl.end_) - impl.buf_;
+    if (impl.begin_ < impl.end_)
+      break;
+    if (0 == impl.Fill()) {
+      impl.length_ = -1;                        // make iterator invalid
+      return;
     }
   }
 
-  if (impl_->length_ > 0)
-    impl_->AddChar(kNullChar);               // always append a null char
-  else
-    impl_->length_ = -1;                     // or make iterator invalid
+  if ('\n' == impl.buf_[impl.begin_]) {         // found a newline
+    ++impl.begin_;
+    impl.token_ = kNewLineToken;
+    impl.length_ = 1;
+    return;
+  }
+
+  int end = impl.begin_ + 1;                    // found a "word"
+  for (;;) {
+    end = CharScan::FindSpace(impl.buf_ + end, impl.buf_ + impl.end_) -
+          impl.buf_;
+    if (end < impl.end_)
+      break;
+    const int scanned = end - impl.begin_;
+    const int numRead = impl.Fill();
+    end = impl.begin_ + scanned;
+    if (0 == numRead)
+      break;                                    // "word" ends the input
+  }
+
+  if (end < impl.end_ && '\n' == impl.buf_[end])
+    impl.newline_flag_ = 1;                     // note newline for later
+
+  impl.buf_[end] = '\0';                        // end of "word" in any case
+  impl.token_ = impl.buf_ + impl.begin_;
+  impl.length_ = end - impl.begin_;
+  impl.begin_ = end < impl.end_ ? end + 1 : end;
 }
 
 TokenIterator::operator const void *() const {
@@ -111,7 +149,11 @@ TokenIterator::operator const void *() const {
 }
 
 const char* TokenIterator::operator()() const {
-  return impl_->buf_;
+  return impl_->token_;
+}
+
+int TokenIterator::Length() const {
+  return impl_->length_;
 }
 
 }  // namespace idep
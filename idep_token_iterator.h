@@ -9,18 +9,24 @@ namespace idep {
 
 class TokenIteratorImpl;
 
-// Iterate over the tokens in an input stream.
+// Iterate over the tokens in an input stream.  The stream is read in
+// large blocks, and each token is returned in place within the block
+// that holds it, so reading costs little more than scanning the
+// characters once.
 class TokenIterator {
  public:
   // Create a token iterator for the specified stream.  A "token" is
   // either a newline ('\n') or a "word" consisting of a contiguous
   // sequence of non-white-space characters.  The stream object must
-  // continue to exist while the iterator is in use.
+  // continue to exist while the iterator is in use, and should not be
+  // read otherwise meanwhile, since the iterator reads ahead of the
+  // current token.
   TokenIterator(std::istream& in);
   ~TokenIterator();
 
   // Advance to next token (i.e., "word" or newline).  The behavior is
-  // undefined if the iteration state is not valid.
+  // undefined if the iteration state is not valid.  The characters of
+  // the previous token are no longer valid afterwards.
   void operator++();
 
   // Return non-zero if current token is valid; else 0.
@@ -30,6 +36,10 @@ class TokenIterator {
   // is undefined if the iteration state is not valid.
   const char* operator()() const;
 
+  // Return the length of the current token (i.e., strlen(operator()())).
+  // The behavior is undefined if the iteration state is not valid.
+  int Length() const;
+
  private:
   TokenIteratorImpl* impl_;
 
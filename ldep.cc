@@ -1,4 +1,8 @@
 #include "idep_link_dep.h"
+#include "idep_condensation.h"
+#include "idep_row_kernel.h"
+
+#include <stdlib.h>
 
 #include <iostream>
 
@@ -11,6 +15,7 @@ return
 "  The following command line interface is supported:\n"
 "\n"
 "    ldep [-U<dir>] [-u<un>] [-a<aliases>] [-d<deps>] [-l|-L] [-x|-X] [-s]\n"
+"         [-K<kernel>] [-j<threads>]\n"
 "\n"
 "      -U<dir>     Specify directory not to group as a package.\n"
 "      -u<un>      Specify file containing directories not to group.\n"
@@ -21,6 +26,8 @@ return
 "      -x          Suppress printing any alias/unalias information.\n"
 "      -X          Suppress printing all but the levelized component names.\n"
 "      -s          Do _not_ remove suffixes; consider each file separately.\n"
+"      -K<kernel>  Force the closure kernel: scalar, sse2, avx2 or avx512.\n"
+"      -j<threads> Use this many threads for closures (0: one per processor).\n"
 "\n"
 "    This command takes no arguments.  The dependencies themselves will\n"
 "    come from standard input unless the -d option has been invoked.\n"
@@ -61,6 +68,18 @@ static int incorrect(const char *file, char option) {
     return s_status;
 }
 
+static int unsupported(const char *kernel, char option) {
+    PrintError() << "kernel \"" << kernel << "\" is unknown or not supported"
+          << " by this processor for -" << option << " option." << std::endl;
+    return s_status;
+}
+
+static int invalidCount(const char *count, char option) {
+    PrintError() << "invalid count \"" << count << "\" for -"
+          << option << " option." << std::endl;
+    return s_status;
+}
+
 static const char *getArg(int *i, int argc, const char *argv[]) {
     return 0 != argv[*i][2] ? argv[*i] + 2 :
            ++*i >= argc || '-' == argv[*i][0] ? "" : argv[*i];
@@ -152,6 +171,27 @@ int main(int argc, char* argv[]) {
                 }
                 suppression = 2;
               } break;
+              case 'K': {
+                const char *arg = getArg(&i, argc, (const char **)argv);
+                if (!*arg) {
+                    return missing("kernel", option);
+                }
+                if (!idep::RowKernel::Select(arg)) {
+                    return unsupported(arg, option);
+                }
+              } break;
+              case 'j': {
+                const char *arg = getArg(&i, argc, (const char **)argv);
+                if (!*arg) {
+                    return missing("threads", option);
+                }
+                char *end;
+                long threads = strtol(arg, &end, 10);
+                if (*end || threads < 0 || threads > 1024) {
+                    return invalidCount(arg, option);
+                }
+                idep::Condensation::setNumThreads(threads);
+              } break;
               default: {
                  PrintError() << "unknown option \"" << word << "\"." << std::endl
                        << help();